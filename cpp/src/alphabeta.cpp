@@ -0,0 +1,470 @@
+#include "headers/alphabeta.h"
+#include "headers/eval.h"
+#include "headers/symmetry.h"
+#include "headers/utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace Hive {
+
+    namespace {
+        // Lazy SMP depth skipping of helper threads: helper i skips depth d if ((d + phase) / size) is odd
+        constexpr std::array<int, 20> SKIP_SIZE  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+        constexpr std::array<int, 20> SKIP_PHASE = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+        // Minimum weight of a vote, so that the thread with the lowest score still counts
+        constexpr int VOTE_MARGIN = 20;
+
+        // Plies of queen threats searched past the nominal depth
+        constexpr int MAX_QUIESCENCE_DEPTH = 4;
+        // Occupied neighbors of a Queen from which its surround is a tactical matter
+        constexpr int QUIESCENCE_PRESSURE = 5;
+
+        // Late move reductions
+        constexpr int LMR_MIN_DEPTH = 3;    // No reduction close to the leaves
+        constexpr int LMR_MIN_MOVE = 3;     // The first moves are searched at full depth
+        constexpr int LMR_LATE_MOVE = 12;   // Moves from this index on are reduced by 2 plies...
+        constexpr int LMR_DEEP = 6;         // ...when at least this depth is left
+        constexpr int LMR_QUEEN_DISTANCE = 2;
+
+        // Root solver: Queen pressure from which it runs, its depth and budget
+        constexpr int SOLVER_PRESSURE = 4;
+        constexpr int SOLVER_PLIES = 5;
+        constexpr std::uint64_t SOLVER_NODES = 200000;
+        constexpr int SOLVER_TIME_DIVISOR = 4;      // At most a quarter of the move time
+
+        // True if the cell is more than LMR_QUEEN_DISTANCE cells away from both Queens
+        bool isFarFromQueens(const Board& board, const Coord& cell) {
+            for (Color c : {Color::White, Color::Black}) {
+                Coord queen;
+                if (board.locate({c, Bug::Queen, 0}, queen) && hexDistance(cell, queen) <= LMR_QUEEN_DISTANCE) return false;
+            }
+            return true;
+        }
+    }
+
+    Move AlphaBetaEngine::getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) {
+        (void)hand; // Both hands are derived from the board by Position::fromBoard
+        if (validMoves.empty()) return PASS_MOVE;
+
+        // The tables are mapped by the first search (see largepages.h)
+        if (tt.allocate() && verbose) std::cerr << PagesInfo("hash", tt.sizeMB(), tt.backing()) << std::endl;
+        if (evalCache.allocate() && verbose) std::cerr << PagesInfo("evalcache", evalCache.sizeMB(), evalCache.backing()) << std::endl;
+        if (useSolver && solver.allocate() && verbose) std::cerr << PagesInfo("solver", solver.sizeMB(), solver.backing()) << std::endl;
+
+        timeManager.start(limits);
+        // Cleared, then raised again if stop() came first: a stop request racing with the start is never lost
+        stopped = false;
+        if (stopRequested) stopped = true;
+        tt.newSearch();
+        maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+
+        Position root = Position::fromBoard(board, turnPlayer);
+        root.setGameKeys(gameKeys);
+        // The solver cannot be interrupted: a ponder search, which ends on stop() only, goes without it
+        if (useSolver && !limits.infinite() && solveRoot(root, validMoves)) return result.move;
+
+        // Symmetric equivalents of a root move are searched once
+        const std::vector<Move> rootMoves = symmetry ? UniqueMoves(root, validMoves) : validMoves;
+
+        workers.clear();
+        for (int i = 0; i < threadCount; ++i) {
+            auto w = std::make_unique<Worker>();
+            w->id = i;
+            w->pos = root;
+            w->rootMoves = rootMoves;
+            w->bestMove = rootMoves.front();
+            workers.push_back(std::move(w));
+        }
+
+        // Helpers first, then the main worker in the calling thread
+        std::unique_ptr<Watchdog> watchdog;
+        if (timeManager.timed()) watchdog = std::make_unique<Watchdog>(stopped, timeManager.hardDeadline());
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < threadCount; ++i) {
+            helpers.emplace_back([this, i] { iterativeDeepening(*workers[i]); });
+        }
+        iterativeDeepening(*workers[0]);
+        stopped = true;
+        for (auto& t : helpers) t.join();
+        watchdog.reset();
+
+        const Worker& best = vote();
+        result.move = best.bestMove;
+        result.score = best.bestScore;
+        result.depth = best.completedDepth;
+        result.nodes = totalNodes();
+        result.time = elapsed();
+        result.pv.assign(best.pvTable[0].begin(), best.pvTable[0].begin() + best.pvLength[0]);
+        if (result.pv.empty() || result.pv.front() != result.move) result.pv = {result.move};
+
+        return result.move;
+    }
+
+    bool AlphaBetaEngine::solveRoot(const Position& root, const std::vector<Move>& validMoves) {
+        if (std::max(root.queenPressure(Color::White), root.queenPressure(Color::Black)) < SOLVER_PRESSURE) return false;
+
+        const DfpnResult solved = solver.solve(root, SOLVER_PLIES, SOLVER_NODES, limits.moveTime / SOLVER_TIME_DIVISOR);
+        if (verbose) ReportSolve(solved, root, SOLVER_PLIES);
+        // Losses are left to the search, which finds the longest resistance
+        if (solved.proof != Proof::Win || solved.line.empty()) return false;
+        if (std::find(validMoves.begin(), validMoves.end(), solved.line.front()) == validMoves.end()) return false;
+
+        result = SearchResult();
+        result.move = solved.line.front();
+        result.score = MATE_SCORE - static_cast<int>(solved.line.size());
+        result.depth = static_cast<int>(solved.line.size());
+        result.nodes = solved.nodes;
+        result.time = elapsed();
+        result.pv = solved.line;
+        return true;
+    }
+
+    void AlphaBetaEngine::iterativeDeepening(Worker& w) {
+        const bool mainThread = (w.id == 0);
+
+        for (int depth = 1; depth <= maxDepth && !stopped; ++depth) {
+            // Helpers skip a share of the depths, so that threads are spread over several depths
+            if (!mainThread) {
+                const int idx = (w.id - 1) % static_cast<int>(SKIP_SIZE.size());
+                if (((depth + SKIP_PHASE[idx]) / SKIP_SIZE[idx]) % 2 != 0) continue;
+            }
+
+            const int score = searchRoot(w, depth);
+            if (stopped) break;
+
+            w.bestScore = score;
+            w.completedDepth = depth;
+            if (!mainThread) continue;
+
+            if (verbose) report(w, depth, score);
+
+            // Forced results do not change with depth
+            if (std::abs(score) >= MATE_BOUND) break;
+            // Past the soft deadline, scaled by the stability of the best move and the score trend
+            if (timeManager.iterationDone(w.bestMove, score)) break;
+        }
+    }
+
+    int AlphaBetaEngine::searchRoot(Worker& w, int depth) {
+        int alpha = -INF_SCORE;
+        const int beta = INF_SCORE;
+        w.pvLength[0] = 0;
+
+        for (size_t i = 0; i < w.rootMoves.size(); ++i) {
+            const Move move = w.rootMoves[i];
+            w.pos.play(move);
+            int score;
+            if (i == 0) {
+                score = -search(w, depth - 1, -beta, -alpha, 1);
+            } else {
+                score = -search(w, depth - 1, -alpha - 1, -alpha, 1);
+                if (score > alpha && !stopped) {
+                    score = -search(w, depth - 1, -beta, -alpha, 1);
+                }
+            }
+            w.pos.undo();
+
+            if (stopped) break;
+
+            if (score > alpha) {
+                alpha = score;
+
+                // A partial iteration is still usable: the previous best move is searched first,
+                // so any move that replaced it has a proven better score.
+                w.bestMove = move;
+
+                w.pvTable[0][0] = move;
+                for (int j = 0; j < w.pvLength[1]; ++j) w.pvTable[0][j + 1] = w.pvTable[1][j];
+                w.pvLength[0] = w.pvLength[1] + 1;
+            }
+        }
+
+        // Best move first in the next iteration
+        const Move best = w.bestMove;
+        std::stable_partition(w.rootMoves.begin(), w.rootMoves.end(), [&](const Move& m) { return m == best; });
+        return alpha;
+    }
+
+    int AlphaBetaEngine::search(Worker& w, int depth, int alpha, int beta, int ply) {
+        Position& pos = w.pos;
+        w.pvLength[ply] = 0;
+
+        const std::uint64_t nodes = w.nodes.load(std::memory_order_relaxed) + 1;
+        w.nodes.store(nodes, std::memory_order_relaxed);
+        if (stopped.load(std::memory_order_relaxed)) return 0;
+
+        // Terminal positions: a surrounded Queen ends the game
+        const bool ownSurrounded = pos.isQueenSurrounded(pos.turnPlayer);
+        const bool rivalSurrounded = pos.isQueenSurrounded(rival(pos.turnPlayer));
+        if (ownSurrounded && rivalSurrounded) return 0;
+        if (ownSurrounded) return -MATE_SCORE + ply;
+        if (rivalSurrounded) return MATE_SCORE - ply;
+        if (pos.isRepetitionDraw(ply)) return DRAW_SCORE;
+
+        if (ply >= MAX_PLY - 1) return evaluate(pos);
+        if (depth <= 0) return quiescence(w, alpha, beta, ply, 0);
+
+        // Transposition table: cut-offs outside the principal variation, hash move ordering everywhere
+        const bool pvNode = beta - alpha > 1;
+        const std::uint64_t key = pos.key();
+        TTData entry;
+        std::uint32_t hashMove = 0;
+        if (tt.probe(key, entry)) {
+            hashMove = entry.move;
+            if (!pvNode && entry.depth >= depth) {
+                const int ttScore = scoreFromTT(entry.score, ply);
+                if (entry.bound == Bound::Exact
+                    || (entry.bound == Bound::Lower && ttScore >= beta)
+                    || (entry.bound == Bound::Upper && ttScore <= alpha)) {
+                    return ttScore;
+                }
+            }
+        }
+
+        std::vector<Move> moves = pos.generateMoves();
+        if (moves.empty()) moves.push_back(PASS_MOVE);
+
+        const OrderingTables* tables = ordering ? &w.tables : nullptr;
+        MovePicker picker(pos, moves, hashMove, tables, ply);
+
+        const int alphaOrig = alpha;
+        int bestScore = -INF_SCORE;
+        Move bestMove = PASS_MOVE;
+        std::vector<Move> triedQuiets;
+        Move move;
+        bool quiet;
+        for (int i = 0; picker.next(move, quiet); ++i) {
+            // Late move reduction: quiet placements far from both Queens rarely matter in a shallow search
+            int reduction = 0;
+            if (ordering && !pvNode && quiet && depth >= LMR_MIN_DEPTH && i >= LMR_MIN_MOVE
+                && move.type == Move::Place && isFarFromQueens(pos.board, move.to)) {
+                reduction = 1 + (i >= LMR_LATE_MOVE && depth >= LMR_DEEP);
+            }
+
+            pos.play(move);
+            int score;
+            if (i == 0) {
+                score = -search(w, depth - 1, -beta, -alpha, ply + 1);
+            } else {
+                // Null window: prove the move is not better than the current best
+                score = -search(w, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+                if (score > alpha && reduction > 0) {
+                    score = -search(w, depth - 1, -alpha - 1, -alpha, ply + 1);
+                }
+                if (score > alpha && score < beta) {
+                    score = -search(w, depth - 1, -beta, -alpha, ply + 1);
+                }
+            }
+            pos.undo();
+
+            if (stopped.load(std::memory_order_relaxed)) return 0;
+
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+                if (score > alpha) {
+                    alpha = score;
+
+                    w.pvTable[ply][0] = move;
+                    for (int j = 0; j < w.pvLength[ply + 1]; ++j) w.pvTable[ply][j + 1] = w.pvTable[ply + 1][j];
+                    w.pvLength[ply] = w.pvLength[ply + 1] + 1;
+
+                    if (alpha >= beta) {
+                        if (ordering && quiet && move.type != Move::Pass) {
+                            w.tables.update(pos, move, triedQuiets, depth, ply);
+                        }
+                        break;
+                    }
+                }
+            }
+            if (quiet && move.type != Move::Pass) triedQuiets.push_back(move);
+        }
+
+        const Bound bound = (bestScore >= beta) ? Bound::Lower : (bestScore > alphaOrig ? Bound::Exact : Bound::Upper);
+        tt.store(key, PackMove(bestMove), scoreToTT(bestScore, ply), depth, bound);
+        return bestScore;
+    }
+
+    int AlphaBetaEngine::quiescence(Worker& w, int alpha, int beta, int ply, int qdepth) {
+        Position& pos = w.pos;
+        w.pvLength[ply] = 0;
+
+        const std::uint64_t nodes = w.nodes.load(std::memory_order_relaxed) + 1;
+        w.nodes.store(nodes, std::memory_order_relaxed);
+        if (stopped.load(std::memory_order_relaxed)) return 0;
+
+        const bool ownSurrounded = pos.isQueenSurrounded(pos.turnPlayer);
+        const bool rivalSurrounded = pos.isQueenSurrounded(rival(pos.turnPlayer));
+        if (ownSurrounded && rivalSurrounded) return 0;
+        if (ownSurrounded) return -MATE_SCORE + ply;
+        if (rivalSurrounded) return MATE_SCORE - ply;
+        if (pos.isRepetitionDraw(ply)) return DRAW_SCORE;
+
+        // Stand pat: the player to move is never forced to change a surround
+        const int standPat = evaluate(pos);
+        if (standPat >= beta || qdepth >= MAX_QUIESCENCE_DEPTH || ply >= MAX_PLY - 1) return standPat;
+        alpha = std::max(alpha, standPat);
+
+        // Only Queens close enough to a surround for a few moves to decide it: other positions are quiet
+        std::vector<Move> moves = pos.generateQueenThreats(QUIESCENCE_PRESSURE);
+        MovePicker picker(pos, moves, 0, nullptr, ply);
+
+        int bestScore = standPat;
+        Move move;
+        bool quiet;
+        while (picker.next(move, quiet)) {
+            pos.play(move);
+            const int score = -quiescence(w, -beta, -alpha, ply + 1, qdepth + 1);
+            pos.undo();
+
+            if (stopped.load(std::memory_order_relaxed)) return 0;
+
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) break;
+                }
+            }
+        }
+        return bestScore;
+    }
+
+    int AlphaBetaEngine::scoreToTT(int score, int ply) {
+        if (score >= MATE_BOUND) return score + ply;
+        if (score <= -MATE_BOUND) return score - ply;
+        return score;
+    }
+
+    int AlphaBetaEngine::scoreFromTT(int score, int ply) {
+        if (score >= MATE_BOUND) return score - ply;
+        if (score <= -MATE_BOUND) return score + ply;
+        return score;
+    }
+
+    int AlphaBetaEngine::evaluate(const Position& pos) {
+        if (!evalCache.enabled()) return ActiveNetwork() ? NnueEvaluate(pos) : Evaluate(pos);
+
+        const std::uint64_t key = EvalCacheKey(pos);
+        int score;
+        if (evalCache.probe(key, score)) return score;
+
+        score = ActiveNetwork() ? NnueEvaluate(pos) : Evaluate(pos);
+        evalCache.store(key, score);
+        return score;
+    }
+
+    std::vector<EngineOption> AlphaBetaEngine::getOptions() const {
+        return {
+            {"HashSizeMB", "int", std::to_string(tt.sizeMB()), std::to_string(TranspositionTable::DEFAULT_SIZE_MB), {"1", "65536"}},
+            {"EvalCacheMB", "int", std::to_string(evalCache.sizeMB()), std::to_string(EvalCache::DEFAULT_SIZE_MB), {"0", "4096"}},
+            {"Threads", "int", std::to_string(threadCount), "1", {"1", std::to_string(MAX_THREADS)}},
+            {"Ordering", "bool", ordering ? "True" : "False", "True", {}},
+            {"Solver", "bool", useSolver ? "True" : "False", "True", {}},
+            {"Symmetry", "bool", symmetry ? "True" : "False", "True", {}}
+        };
+    }
+
+    bool AlphaBetaEngine::setOption(const std::string& name, const std::string& value) {
+        try {
+            if (name == "HashSizeMB") {
+                const int mb = std::stoi(value);
+                if (mb < 1 || mb > 65536) return false;
+                tt.resize(static_cast<std::size_t>(mb));
+                return true;
+            }
+            if (name == "EvalCacheMB") {
+                const int mb = std::stoi(value);
+                if (mb < 0 || mb > 4096) return false;
+                evalCache.resize(static_cast<std::size_t>(mb));
+                return true;
+            }
+            if (name == "Threads") {
+                const int threads = std::stoi(value);
+                if (threads < 1 || threads > MAX_THREADS) return false;
+                threadCount = threads;
+                return true;
+            }
+            if (name == "Ordering") {
+                if (value != "True" && value != "False") return false;
+                ordering = (value == "True");
+                return true;
+            }
+            if (name == "Solver") {
+                if (value != "True" && value != "False") return false;
+                useSolver = (value == "True");
+                return true;
+            }
+            if (name == "Symmetry") {
+                if (value != "True" && value != "False") return false;
+                symmetry = (value == "True");
+                return true;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return false;
+    }
+
+    const AlphaBetaEngine::Worker& AlphaBetaEngine::vote() const {
+        int minScore = INF_SCORE;
+        for (const auto& w : workers) {
+            if (w->completedDepth > 0) minScore = std::min(minScore, w->bestScore);
+        }
+
+        // Votes of a move: sum over the threads choosing it of (score margin) * (completed depth)
+        std::vector<std::pair<Move, std::int64_t>> votes;
+        for (const auto& w : workers) {
+            if (w->completedDepth == 0) continue;
+            const std::int64_t weight = static_cast<std::int64_t>(w->bestScore - minScore + VOTE_MARGIN) * w->completedDepth;
+            auto it = std::find_if(votes.begin(), votes.end(), [&](const auto& v) { return v.first == w->bestMove; });
+            if (it == votes.end()) votes.emplace_back(w->bestMove, weight);
+            else it->second += weight;
+        }
+
+        const Worker* best = workers[0].get();
+        std::int64_t bestVotes = -1;
+        for (const auto& w : workers) {
+            if (w->completedDepth == 0) continue;
+            const auto it = std::find_if(votes.begin(), votes.end(), [&](const auto& v) { return v.first == w->bestMove; });
+            // Among the threads with the winning move, the deepest one gives score and PV
+            if (it->second > bestVotes || (it->second == bestVotes && w->completedDepth > best->completedDepth)) {
+                best = w.get();
+                bestVotes = it->second;
+            }
+        }
+        return *best;
+    }
+
+    std::uint64_t AlphaBetaEngine::totalNodes() const {
+        std::uint64_t total = 0;
+        for (const auto& w : workers) total += w->nodes.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void AlphaBetaEngine::report(Worker& w, int depth, int score) const {
+        const std::uint64_t nodes = totalNodes();
+        const auto ms = elapsed().count();
+        const auto nps = nodes * 1000 / static_cast<std::uint64_t>(std::max<long long>(ms, 1));
+
+        std::cerr << "info depth " << depth << " score " << score << " nodes " << nodes
+                  << " nps " << nps << " time " << ms
+                  << " hashfull " << tt.hashfull() << " tthits " << tt.hitRate()
+                  << " evalhits " << evalCache.hitRate() << " pv ";
+
+        // PV moves are converted on the position they are played from
+        int played = 0;
+        for (int i = 0; i < w.pvLength[0]; ++i) {
+            std::cerr << (i > 0 ? ";" : "") << MoveToString(w.pvTable[0][i], w.pos.board);
+            w.pos.play(w.pvTable[0][i]);
+            ++played;
+        }
+        while (played-- > 0) w.pos.undo();
+        std::cerr << std::endl;
+    }
+
+}
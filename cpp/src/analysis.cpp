@@ -0,0 +1,203 @@
+#include "headers/analysis.h"
+#include "headers/alphabeta.h"
+#include "headers/position.h"
+#include "headers/utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace Hive::Analysis {
+
+    namespace {
+        // Interval between two progress lines, and between two looks at the finished count
+        constexpr std::chrono::milliseconds PROGRESS_INTERVAL{1000};
+        constexpr std::chrono::milliseconds POLL_INTERVAL{20};
+
+        // Position of a game before one of its moves
+        struct Task {
+            std::size_t game;
+            std::size_t ply;
+        };
+
+        std::string turnString(const Position& pos) {
+            return std::string(pos.turnPlayer == Color::White ? "White" : "Black") + "[" + std::to_string(pos.turnNumber) + "]";
+        }
+
+        bool isGameState(const std::string& token) {
+            return token == "NotStarted" || token == "InProgress" || token == "Draw"
+                || token == "WhiteWins" || token == "BlackWins";
+        }
+
+        // The moves of a GameString replayed from the start, each checked against the legal moves
+        bool replay(const std::string& gameString, Game& game, std::string& error) {
+            std::istringstream stream(gameString);
+            std::string token;
+            Position pos = Position::fromBoard(Board(), Color::White);
+            int index = 0;
+            for (; std::getline(stream, token, ';'); ++index) {
+                // GameType, GameState and TurnString: the turn follows from the moves
+                if (index == 0 && !IsGameType(token)) {
+                    error = "unknown game type " + token;
+                    return false;
+                }
+                if (index == 1 && !isGameState(token)) {
+                    error = "unknown game state " + token;
+                    return false;
+                }
+                if (index == 1) game.state = token;
+                if (index < 3) continue;
+
+                Move move;
+                try {
+                    move = StringToMove(token, pos.board);
+                } catch (const std::exception& e) {
+                    error = "malformed move " + token + ": " + e.what();
+                    return false;
+                }
+
+                const std::vector<Move> legal = pos.generateMoves();
+                const bool isLegal = (move.type == Move::Pass) ? legal.empty()
+                                                               : std::find(legal.begin(), legal.end(), move) != legal.end();
+                if (!isLegal) {
+                    error = "illegal move " + token + " at ply " + std::to_string(index - 3);
+                    return false;
+                }
+                if (move.type == Move::Pass) move = PASS_MOVE;
+
+                game.moveStrings.push_back(token);
+                game.moves.push_back(move);
+                pos.play(move);
+            }
+            if (index < 3) {
+                error = "missing game state or turn";
+                return false;
+            }
+            return true;
+        }
+
+        PlyResult analyzePosition(AlphaBetaEngine& engine, const Game& game, std::size_t ply) {
+            Position pos = Position::fromBoard(Board(), Color::White);
+            for (std::size_t i = 0; i < ply; ++i) pos.play(game.moves[i]);
+
+            PlyResult result;
+            result.turn = turnString(pos);
+
+            const std::vector<Move> moves = pos.generateMoves();
+            if (moves.empty()) {
+                result.best = "pass";
+                result.pv = "pass";
+                return result;
+            }
+
+            engine.clear();
+            engine.setGameKeys(pos.reversibleKeys());
+            engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), moves);
+            const SearchResult& searched = engine.lastResult();
+            result.best = MoveToString(searched.move, pos.board);
+            result.score = searched.score;
+            result.depth = searched.depth;
+            result.nodes = searched.nodes;
+            result.time = searched.time;
+            for (std::size_t i = 0; i < searched.pv.size(); ++i) {
+                result.pv += (i > 0 ? ";" : "") + MoveToString(searched.pv[i], pos.board);
+                pos.play(searched.pv[i]);
+            }
+            return result;
+        }
+    }
+
+    std::vector<Game> readGames(const std::string& path, std::ostream& log) {
+        std::ifstream file(path);
+        if (!file) throw std::invalid_argument("Cannot read games file: " + path);
+
+        std::vector<Game> games;
+        std::string line;
+        for (int number = 1; std::getline(file, line); ++number) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            Game game;
+            game.line = number;
+            std::string error;
+            if (replay(line, game, error)) games.push_back(std::move(game));
+            else log << "err line " << number << ": " << error << ", game skipped" << std::endl;
+        }
+        return games;
+    }
+
+    std::vector<std::vector<PlyResult>> analyze(const std::vector<Game>& games, const Settings& settings, std::ostream& log) {
+        std::vector<std::vector<PlyResult>> results(games.size());
+        std::vector<Task> tasks;
+        for (std::size_t g = 0; g < games.size(); ++g) {
+            results[g].resize(games[g].moves.size());
+            for (std::size_t ply = 0; ply < games[g].moves.size(); ++ply) tasks.push_back({g, ply});
+        }
+
+        SearchLimits limits;
+        if (settings.moveTime.count() > 0) {
+            limits.moveTime = settings.moveTime;
+        } else {
+            limits.moveTime = NO_TIME_LIMIT;
+            limits.depth = settings.depth;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        auto seconds = [&] {
+            return std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-3);
+        };
+
+        // Positions are handed out one at a time: their costs vary too much for a static split
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        const int threadCount = std::max(1, std::min<int>(settings.threads, static_cast<int>(std::max<std::size_t>(tasks.size(), 1))));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&] {
+                AlphaBetaEngine engine;
+                engine.setVerbose(false);
+                engine.setOption("HashSizeMB", std::to_string(settings.hashMB));
+                engine.setLimits(limits);
+                for (std::size_t i = next++; i < tasks.size(); i = next++) {
+                    results[tasks[i].game][tasks[i].ply] = analyzePosition(engine, games[tasks[i].game], tasks[i].ply);
+                    ++done;
+                }
+            });
+        }
+
+        log << "analyzing " << tasks.size() << " positions of " << games.size() << " games on " << threadCount << " threads" << std::endl;
+        auto lastReport = start;
+        while (done < tasks.size()) {
+            std::this_thread::sleep_for(POLL_INTERVAL);
+            const auto now = std::chrono::steady_clock::now();
+            const std::size_t finished = done;
+            if (finished == tasks.size() || now - lastReport < PROGRESS_INTERVAL) continue;
+            lastReport = now;
+
+            const double rate = static_cast<double>(finished) / seconds();
+            log << "info positions " << finished << "/" << tasks.size() << " pps " << std::fixed << std::setprecision(1) << rate
+                << " eta " << std::setprecision(0) << (rate > 0 ? static_cast<double>(tasks.size() - finished) / rate : 0.0) << "s" << std::endl;
+        }
+        for (auto& t : threads) t.join();
+
+        log << "analyzed " << tasks.size() << " positions in " << std::fixed << std::setprecision(2) << seconds() << " s, "
+            << std::setprecision(1) << static_cast<double>(tasks.size()) / seconds() << " positions/s" << std::endl;
+        return results;
+    }
+
+    void writeResults(std::ostream& out, const std::vector<Game>& games, const std::vector<std::vector<PlyResult>>& results) {
+        out << "game\tply\tturn\tplayed\tbest\tscore\tdepth\tnodes\ttime_ms\tpv\n";
+        for (std::size_t g = 0; g < games.size(); ++g) {
+            for (std::size_t ply = 0; ply < results[g].size(); ++ply) {
+                const PlyResult& r = results[g][ply];
+                out << games[g].line << '\t' << ply << '\t' << r.turn << '\t' << games[g].moveStrings[ply] << '\t' << r.best
+                    << '\t' << r.score << '\t' << r.depth << '\t' << r.nodes << '\t' << r.time.count() << '\t' << r.pv << '\n';
+            }
+        }
+    }
+
+}
@@ -0,0 +1,69 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "headers/analysis.h"
+#include "headers/eval.h"
+#include "headers/nnue.h"
+
+// Batch analysis of a corpus of games (see analysis.h):
+//     high_hive_analyze <games file> [--out <file>] [--threads N] [--depth N | --movetime <ms>] [--hash <MB>]
+//                       [--eval <weights file>] [--nnue <network file>]
+// The table goes to --out, or to stdout; the progress and errors to stderr.
+
+namespace {
+    void usage() {
+        std::cerr << "usage: high_hive_analyze <games file> [--out <file>] [--threads N] [--depth N | --movetime <ms>]"
+                     " [--hash <MB>] [--eval <weights file>] [--nnue <network file>]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+
+    Hive::Analysis::Settings settings;
+    settings.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string input;
+    std::string output;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--out" && hasValue) output = argv[++i];
+            else if (arg == "--threads" && hasValue) settings.threads = std::stoi(argv[++i]);
+            else if (arg == "--depth" && hasValue) settings.depth = std::stoi(argv[++i]);
+            else if (arg == "--movetime" && hasValue) settings.moveTime = std::chrono::milliseconds(std::stoll(argv[++i]));
+            else if (arg == "--hash" && hasValue) settings.hashMB = static_cast<std::size_t>(std::stoul(argv[++i]));
+            else if (arg == "--eval" && hasValue) Hive::SetEvalWeights(Hive::LoadEvalWeights(argv[++i]));
+            else if (arg == "--nnue" && hasValue) Hive::SetNetwork(Hive::Network::load(argv[++i]));
+            else if (input.empty() && arg.rfind("--", 0) != 0) input = arg;
+            else {
+                usage();
+                return 1;
+            }
+        }
+        if (input.empty() || settings.threads < 1 || settings.depth < 1 || settings.hashMB < 1 || settings.moveTime.count() < 0) {
+            usage();
+            return 1;
+        }
+
+        const std::vector<Hive::Analysis::Game> games = Hive::Analysis::readGames(input, std::cerr);
+        const auto results = Hive::Analysis::analyze(games, settings, std::cerr);
+
+        if (output.empty()) {
+            Hive::Analysis::writeResults(std::cout, games, results);
+        } else {
+            std::ofstream file(output);
+            if (!file) {
+                std::cerr << "err Cannot write " << output << std::endl;
+                return 1;
+            }
+            Hive::Analysis::writeResults(file, games, results);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "err " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,384 @@
+#include "headers/bench.h"
+#include "headers/alphabeta.h"
+#include "headers/eval.h"
+#include "headers/mcts.h"
+#include "headers/nnue.h"
+#include "headers/position.h"
+#include "headers/rollout.h"
+#include "headers/symmetry.h"
+#include "headers/utils.h"
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+namespace Hive::Bench {
+
+    namespace {
+        // Searches a position to a fixed depth, returning the search statistics. Without the root solver: its
+        // nodes are not in the search counts, and a proof would replace the search being measured
+        SearchResult searchToDepth(AlphaBetaEngine& engine, const std::string& notation, int depth) {
+            const Position pos = StringToPosition(notation);
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.moveTime = std::chrono::hours(1);
+            engine.setLimits(limits);
+            engine.setOption("Solver", "False");
+            engine.clear();
+
+            std::vector<Move> moves = pos.generateMoves();
+            if (moves.empty()) moves.push_back(PASS_MOVE);
+            engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), moves);
+            return engine.lastResult();
+        }
+    }
+
+    namespace {
+        // Games longer than this are adjudicated as draws
+        constexpr int MAX_GAME_PLIES = 150;
+
+        // Plays a game from a position. Returns 1 if first wins, 0 if second wins, 0.5 for a draw.
+        // first plays the player to move in the starting position
+        double playGame(Engine& first, Engine& second, Position pos) {
+            const Color firstColor = pos.turnPlayer;
+            for (int ply = 0; ply < MAX_GAME_PLIES; ++ply) {
+                const bool whiteSurrounded = pos.isQueenSurrounded(Color::White);
+                const bool blackSurrounded = pos.isQueenSurrounded(Color::Black);
+                if (whiteSurrounded || blackSurrounded) {
+                    if (whiteSurrounded && blackSurrounded) return 0.5;
+                    const Color loser = whiteSurrounded ? Color::White : Color::Black;
+                    return (loser == firstColor) ? 0.0 : 1.0;
+                }
+
+                Engine& engine = (pos.turnPlayer == firstColor) ? first : second;
+                std::vector<Move> moves = pos.generateMoves();
+                const Move move = moves.empty() ? PASS_MOVE
+                                                : engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), moves);
+                pos.play(move);
+            }
+            return 0.5;
+        }
+    }
+
+    namespace {
+        // Playouts longer than this are stopped unfinished
+        constexpr int MAX_ROLLOUT_PLIES = 100;
+        // Attack weight of the biased sampler
+        constexpr double ROLLOUT_ATTACK_WEIGHT = 4.0;
+
+        // Random playout by full generation: the reference for the sampler. Returns True on a surround
+        bool generatedPlayout(Position& pos, std::mt19937_64& rng, int& plies) {
+            bool decisive = false;
+            plies = 0;
+            while (true) {
+                if (pos.isQueenSurrounded(Color::White) || pos.isQueenSurrounded(Color::Black)) {
+                    decisive = true;
+                    break;
+                }
+                if (plies >= MAX_ROLLOUT_PLIES) break;
+
+                const std::vector<Move> moves = pos.generateMoves();
+                pos.play(moves.empty() ? PASS_MOVE : moves[std::uniform_int_distribution<std::size_t>(0, moves.size() - 1)(rng)]);
+                ++plies;
+            }
+            for (int i = 0; i < plies; ++i) pos.undo();
+            return decisive;
+        }
+
+        // Playouts, moves and surrounds of a run, with its time
+        struct RolloutRun {
+            std::uint64_t moves = 0;
+            int decisive = 0;
+            double seconds = 0.0;
+        };
+
+        template <typename PlayoutFn>
+        RolloutRun timeRollouts(int playouts, PlayoutFn playout) {
+            RolloutRun run;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < playouts; ++i) {
+                int plies = 0;
+                if (playout(plies)) ++run.decisive;
+                run.moves += static_cast<std::uint64_t>(plies);
+            }
+            run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return run;
+        }
+
+        void reportRollouts(std::ostream& out, const char* name, const RolloutRun& run, int playouts) {
+            const double seconds = std::max(run.seconds, 1e-9);
+            out << " | " << name << " pps " << static_cast<std::uint64_t>(playouts / seconds)
+                << " mps " << static_cast<std::uint64_t>(static_cast<double>(run.moves) / seconds)
+                << " decisive " << std::fixed << std::setprecision(1) << 100.0 * run.decisive / playouts << "%" << std::defaultfloat;
+        }
+    }
+
+    const std::vector<std::string>& positions() {
+        static const std::vector<std::string> POSITIONS = {
+            // Opening
+            "Base+MLP;White[3];bQ;0,0=wQ/1,0=wS1/2,0=bS1/3,0=bQ;B1B2S2G1G2G3A1A2A3LMP;B1B2S2G1G2G3A1A2A3LMP",
+            "Base+MLP;Black[6];wB2;3,0=bL/2,1=bM/0,2=bQ/1,2=wS1/0,3=wM/1,3=wQ/2,3=wL/0,4=wB1/0,5=wB2;S2G1G2G3A1A2A3P;B1B2S1S2G1G2G3A1A2A3P",
+            "Base+MLP;Black[6];wS1;5,0=bS2/2,1=bQ/3,1=bS1/4,1=bP/2,2=bM/2,3=wM/2,4=wA1/2,5=wB1/1,6=wQ/0,7=wP/0,8=wS1;B2S2G1G2G3A2A3L;B1B2G1G2G3A1A2A3L",
+            // Midgame
+            "Base+MLP;Black[11];wG1;5,0=bP/6,0=bA1/4,1=bL/5,1=bB1/3,2=bM/4,2=bA2/5,2=bS1/0,3=wM/1,3=bQ/2,3=wS1/5,3=wA1/2,4=wQ/3,4=wL/5,4=wG1/1,5=wB1/1,6=wB2;S2G2G3A2A3P;B2S2G1G2G3A3",
+            "Base+MLP;Black[11];wB2;3,0=bL/4,0=bB1/6,0=bS2/3,1=bQ/4,1=bS1/5,1=bP/3,2=bM/5,2=bB2/6,2=bG1/3,3=wM/3,4=wA1/1,5=wB2/3,5=wB1/4,5=wS2/1,6=wS1/2,6=wQ/0,7=wA2/1,7=wP;G1G2G3A3L;G2G3A1A2A3",
+            "Base+MLP;Black[16];wG3;5,0=bP/5,1=bLbB2/6,1=bB1/1,2=wA2/4,2=bM/5,2=bA2/6,2=bS1/1,3=wM/2,3=bQ/3,3=wS1/6,3=wA1/8,3=bA1/0,4=wG2/3,4=wQ/4,4=wL/6,4=wG1/7,4=wP/2,5=wB1/4,5=wS2/7,5=wG3/2,6=wB2;A3;S2G1G2G3A3"
+        };
+        return POSITIONS;
+    }
+
+    void smp(std::ostream& out, int depth, int maxThreads) {
+        AlphaBetaEngine engine;
+        engine.setVerbose(false);
+
+        double baseTime = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            engine.setOption("Threads", std::to_string(threads));
+
+            std::uint64_t nodes = 0;
+            std::chrono::milliseconds time{0};
+            for (const auto& notation : positions()) {
+                const SearchResult r = searchToDepth(engine, notation, depth);
+                nodes += r.nodes;
+                time += r.time;
+            }
+
+            const double ms = static_cast<double>(std::max<long long>(time.count(), 1));
+            if (threads == 1) baseTime = ms;
+            out << "threads " << threads << " depth " << depth << " nodes " << nodes
+                << " time " << time.count() << " nps " << static_cast<std::uint64_t>(nodes * 1000 / ms)
+                << " speedup " << std::fixed << std::setprecision(2) << baseTime / ms << "\n";
+        }
+    }
+
+    void ordering(std::ostream& out, int depth) {
+        AlphaBetaEngine engine;
+        engine.setVerbose(false);
+
+        std::uint64_t totalOff = 0, totalOn = 0;
+        const auto& notations = positions();
+        for (size_t i = 0; i < notations.size(); ++i) {
+            engine.setOption("Ordering", "False");
+            const SearchResult off = searchToDepth(engine, notations[i], depth);
+            engine.setOption("Ordering", "True");
+            const SearchResult on = searchToDepth(engine, notations[i], depth);
+            totalOff += off.nodes;
+            totalOn += on.nodes;
+
+            out << "position " << i + 1 << " depth " << depth << " nodes " << off.nodes << " -> " << on.nodes
+                << " time " << off.time.count() << " -> " << on.time.count()
+                << " ratio " << std::fixed << std::setprecision(2)
+                << static_cast<double>(off.nodes) / static_cast<double>(std::max<std::uint64_t>(on.nodes, 1)) << "\n";
+        }
+        out << "total depth " << depth << " nodes " << totalOff << " -> " << totalOn
+            << " ratio " << std::fixed << std::setprecision(2)
+            << static_cast<double>(totalOff) / static_cast<double>(std::max<std::uint64_t>(totalOn, 1)) << "\n";
+    }
+
+    void mcts(std::ostream& out, int moveTimeMs, int maxThreads, int games) {
+        SearchLimits limits;
+        limits.moveTime = std::chrono::milliseconds(moveTimeMs);
+
+        for (int threads : {1, 4, 16, 32}) {
+            if (threads > maxThreads) break;
+
+            MctsEngine engine;
+            engine.setVerbose(false);
+            engine.setLimits(limits);
+            engine.setOption("Threads", std::to_string(threads));
+
+            std::uint64_t playouts = 0, collisions = 0;
+            std::chrono::milliseconds time{0};
+            for (const auto& notation : positions()) {
+                const Position pos = StringToPosition(notation);
+                engine.clear();
+                engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), pos.generateMoves());
+                playouts += engine.lastStats().playouts;
+                collisions += engine.lastStats().collisions;
+                time += engine.lastStats().time;
+            }
+            out << "threads " << threads << " playouts " << playouts << " time " << time.count()
+                << " pps " << playouts * 1000 / static_cast<std::uint64_t>(std::max<long long>(time.count(), 1))
+                << " collisions " << collisions << std::endl;
+
+            if (games <= 0 || threads == 1) continue;
+
+            // Strength: the same engine against a single thread one, alternating colors
+            MctsEngine reference;
+            reference.setVerbose(false);
+            reference.setLimits(limits);
+
+            double score = 0.0;
+            int wins = 0, draws = 0;
+            for (int g = 0; g < games; ++g) {
+                const Position start = StringToPosition(positions()[(g / 2) % positions().size()]);
+                engine.clear();
+                reference.clear();
+                const double result = (g % 2 == 0) ? playGame(engine, reference, start) : 1.0 - playGame(reference, engine, start);
+                score += result;
+                wins += (result == 1.0);
+                draws += (result == 0.5);
+            }
+            out << "threads " << threads << " games " << games << " wins " << wins << " draws " << draws
+                << " losses " << games - wins - draws << " score " << std::fixed << std::setprecision(1)
+                << 100.0 * score / games << "%" << std::defaultfloat << std::endl;
+        }
+    }
+
+    void graph(std::ostream& out, int playouts) {
+        SearchLimits limits;
+        limits.moveTime = std::chrono::hours(1);
+
+        MctsEngine engine;
+        engine.setVerbose(false);
+        engine.setLimits(limits);
+        engine.setOption("MaxPlayouts", std::to_string(playouts));
+
+        const auto& notations = positions();
+        for (size_t i = 0; i < notations.size(); ++i) {
+            const Position pos = StringToPosition(notations[i]);
+            out << "position " << i + 1;
+            for (const char* mode : {"False", "True"}) {
+                engine.setOption("GraphSearch", mode);
+                engine.clear();
+                engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), pos.generateMoves());
+                const MctsStats& s = engine.lastStats();
+                const std::size_t distinct = engine.distinctPositions();
+                out << (mode[0] == 'T' ? " | graph" : " | tree") << " evals " << s.evaluations << " positions " << distinct
+                    << " per position " << std::fixed << std::setprecision(2)
+                    << static_cast<double>(s.evaluations) / static_cast<double>(std::max<std::size_t>(distinct, 1))
+                    << std::defaultfloat << " transpositions " << s.transpositions << " time " << s.time.count();
+            }
+            out << std::endl;
+        }
+    }
+
+    void widening(std::ostream& out, int playouts) {
+        SearchLimits limits;
+        limits.moveTime = std::chrono::hours(1);
+
+        MctsEngine engine;
+        engine.setVerbose(false);
+        engine.setLimits(limits);
+        engine.setOption("MaxPlayouts", std::to_string(playouts));
+
+        const auto& notations = positions();
+        for (size_t i = 0; i < notations.size(); ++i) {
+            const Position pos = StringToPosition(notations[i]);
+            out << "position " << i + 1;
+            for (const char* mode : {"False", "True"}) {
+                engine.setOption("Widening", mode);
+                engine.clear();
+                const Move move = engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), pos.generateMoves());
+                const MctsStats& s = engine.lastStats();
+                out << (mode[0] == 'T' ? " | widening" : " | full") << " time " << s.time.count() << " edges " << s.edges
+                    << " widenings " << s.widenings << " move " << MoveToString(move, pos.board)
+                    << " value " << std::fixed << std::setprecision(3) << s.value << std::defaultfloat;
+            }
+            out << std::endl;
+        }
+    }
+
+    void rollout(std::ostream& out, int playouts) {
+        playouts = std::max(playouts, 1);
+        const auto& notations = positions();
+        double generatedTime = 0.0, sampledTime = 0.0;
+        for (size_t i = 0; i < notations.size(); ++i) {
+            Position pos = StringToPosition(notations[i]);
+
+            std::mt19937_64 rng(i);
+            const RolloutRun generated = timeRollouts(playouts, [&](int& plies) { return generatedPlayout(pos, rng, plies); });
+
+            RolloutPolicy policy(i);
+            const RolloutRun sampled = timeRollouts(playouts, [&](int& plies) { return policy.playout(pos, MAX_ROLLOUT_PLIES, plies) != 0.0f; });
+
+            policy.setAttackWeight(ROLLOUT_ATTACK_WEIGHT);
+            const RolloutRun attack = timeRollouts(playouts, [&](int& plies) { return policy.playout(pos, MAX_ROLLOUT_PLIES, plies) != 0.0f; });
+
+            generatedTime += generated.seconds;
+            sampledTime += sampled.seconds;
+            out << "position " << i + 1;
+            reportRollouts(out, "generate", generated, playouts);
+            reportRollouts(out, "sample", sampled, playouts);
+            reportRollouts(out, "attack", attack, playouts);
+            out << " speedup " << std::fixed << std::setprecision(2) << generated.seconds / std::max(sampled.seconds, 1e-9)
+                << std::defaultfloat << std::endl;
+        }
+        out << "total speedup " << std::fixed << std::setprecision(2) << generatedTime / std::max(sampledTime, 1e-9)
+            << std::defaultfloat << "\n";
+    }
+
+    void nnue(std::ostream& out, int evals) {
+        evals = std::max(evals, 1);
+        // Plays each child of the position in turn, scoring it with evaluate. Returns evaluations per second
+        auto timeEvals = [evals](Position& pos, const std::vector<Move>& moves, const auto& evaluate) {
+            std::int64_t checksum = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < evals; ++i) {
+                pos.play(moves[static_cast<std::size_t>(i) % moves.size()]);
+                checksum += evaluate(pos);
+                pos.undo();
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return checksum == 1 ? 0.0 : evals / std::max(seconds, 1e-9);  // The checksum keeps the calls alive
+        };
+
+        out << "kernels " << NnueKernels() << " features " << NNUE_FEATURES << " layers 2x" << NNUE_L1 << "-" << NNUE_L2
+            << "-" << NNUE_L3 << "-1" << std::endl;
+        const auto& notations = positions();
+        for (size_t i = 0; i < notations.size(); ++i) {
+            Position pos = StringToPosition(notations[i]);
+            const std::vector<Move> moves = pos.generateMoves();
+            const double hce = timeEvals(pos, moves, [](const Position& p) { return Evaluate(p); });
+
+            // Built again under the network, for a fresh accumulator
+            std::unique_ptr<Network> previous = SetNetwork(Network::random(1));
+            pos = StringToPosition(notations[i]);
+            const Network& network = *ActiveNetwork();
+            const double incremental = timeEvals(pos, moves, [](const Position& p) { return NnueEvaluate(p); });
+            const double scratch = timeEvals(pos, moves, [&](const Position& p) { return network.forward(network.compute(p.board), p.turnPlayer); });
+
+            int mismatches = 0;
+            for (const Move& m : moves) {
+                pos.play(m);
+                if (NnueEvaluate(pos) != network.forward(network.compute(pos.board), pos.turnPlayer)) ++mismatches;
+                pos.undo();
+            }
+            SetNetwork(std::move(previous));
+
+            out << "position " << i + 1 << " eps hce " << static_cast<std::uint64_t>(hce)
+                << " nnue " << static_cast<std::uint64_t>(incremental) << " scratch " << static_cast<std::uint64_t>(scratch)
+                << " speedup " << std::fixed << std::setprecision(2) << incremental / std::max(scratch, 1e-9) << std::defaultfloat
+                << " mismatches " << mismatches << std::endl;
+        }
+    }
+
+    void symmetry(std::ostream& out, int depth) {
+        AlphaBetaEngine engine;
+        engine.setVerbose(false);
+
+        // The first two plies, where most moves are symmetric, then the benchmark positions
+        Position opening = Position::fromBoard(Board(), Color::White);
+        std::vector<std::string> notations = {PositionToString(opening)};
+        opening.play(opening.generateMoves().front());
+        notations.push_back(PositionToString(opening));
+        notations.insert(notations.end(), positions().begin(), positions().end());
+
+        for (size_t i = 0; i < notations.size(); ++i) {
+            const Position pos = StringToPosition(notations[i]);
+            const std::vector<Move> moves = pos.generateMoves();
+            const auto start = std::chrono::steady_clock::now();
+            const std::size_t unique = UniqueMoves(pos, moves).size();
+            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            out << "position " << i << " moves " << moves.size() << " unique " << unique << " dedup_us " << micros;
+            for (const char* mode : {"False", "True"}) {
+                engine.setOption("Symmetry", mode);
+                const SearchResult r = searchToDepth(engine, notations[i], depth);
+                out << (mode[0] == 'T' ? " | symmetry" : " | all") << " nodes " << r.nodes << " time " << r.time.count();
+            }
+            out << std::endl;
+        }
+    }
+
+}
@@ -4,27 +4,49 @@
 namespace Hive {
 
     void Board::place (Coord coord, Piece piece) {
-        int idx = AxToIndex(coord);
+        const int idx = AxToIndex(coord);
 
         if (_grid[idx].empty()) {
+            _slots[idx] = static_cast<std::int8_t>(_occupied_coords.size());
             _occupied_coords.push_back(coord);
+            countNeighbors(idx, 1);
+        } else {
+            countMobility(idx, -1);
+            ++_eval.covered[static_cast<int>(_grid[idx].top().color)];
+            ++_eval.climbers[static_cast<int>(piece.color)];
         }
+
+        _key ^= zobristPiece(pieceIndex(piece), idx, _grid[idx].size());
         _grid[idx].push(piece);
+        _piece_cells[pieceIndex(piece)] = idx;
+        ++_eval.onBoard[static_cast<int>(piece.color)][static_cast<int>(piece.bug)];
+        countMobility(idx, 1);
+        updateAccumulator(piece, idx, _grid[idx].size() - 1, 1);
     }
 
     Piece Board::remove(Coord coord) {
         const int idx = AxToIndex(coord);
+        countMobility(idx, -1);
         const Piece piece = _grid[idx].pop();
+        _piece_cells[pieceIndex(piece)] = -1;
+        _key ^= zobristPiece(pieceIndex(piece), idx, _grid[idx].size());
+        --_eval.onBoard[static_cast<int>(piece.color)][static_cast<int>(piece.bug)];
+        updateAccumulator(piece, idx, _grid[idx].size(), -1);
 
-        if (_grid[idx].empty()) {
-            for (size_t i = 0; i < _occupied_coords.size(); ++i) {
-                if (_occupied_coords[i] == coord) {
-                    _occupied_coords[i] = _occupied_coords.back();
-                    _occupied_coords.pop_back();
-                    break;
-                }   
-            }
+        if (!_grid[idx].empty()) {
+            --_eval.covered[static_cast<int>(_grid[idx].top().color)];
+            --_eval.climbers[static_cast<int>(piece.color)];
+            countMobility(idx, 1);
+            return piece;
         }
+
+        // Swap-remove from the occupied coordinates
+        const int slot = _slots[idx];
+        _occupied_coords[slot] = _occupied_coords.back();
+        _slots[AxToIndex(_occupied_coords[slot])] = static_cast<std::int8_t>(slot);
+        _occupied_coords.pop_back();
+        _slots[idx] = -1;
+        countNeighbors(idx, -1);
         return piece;
     }
 
@@ -33,6 +55,89 @@ namespace Hive {
         place(to, piece);
     }
 
+    void Board::updateAccumulator(const Piece& piece, const int idx, const int level, const int sign) {
+        const Network* network = ActiveNetwork();
+        if (network == nullptr || _nnue_paused) return;
+        if (_nnue.generation != NetworkGeneration()) {
+            _nnue = network->compute(*this);
+            return;
+        }
+
+        for (const Color perspective : {Color::White, Color::Black}) {
+            // The anchor moved: every feature of the perspective changes
+            if (piece.bug == Bug::Queen && piece.color == perspective) {
+                network->refresh(*this, _nnue, perspective);
+                continue;
+            }
+            const int queenIdx = _piece_cells[pieceIndex({perspective, Bug::Queen, 0})];
+            const Coord anchor = IndexToAx(queenIdx);
+            network->update(_nnue, perspective, NnueFeature(perspective, piece, IndexToAx(idx), level, queenIdx >= 0 ? &anchor : nullptr), sign);
+        }
+    }
+
+    void Board::countMobility(const int idx, const int delta) {
+        const Cell& cell = _grid[idx];
+        if (cell.empty()) return;
+        std::uint8_t& count = _eval.mobility[static_cast<int>(cell.top().color)][mobilityBucket(cell.size(), _occupied_neighbors[idx])];
+        count = static_cast<std::uint8_t>(count + delta);
+    }
+
+    void Board::countNeighbors(const int idx, const int delta) {
+        for (int offset : NEIGHBORS) {
+            const int n = idx + offset;
+            const int before = _occupied_neighbors[n];
+            _occupied_neighbors[n] = static_cast<std::uint8_t>(before + delta);
+
+            // Only single pieces change bucket with their neighbors
+            const Cell& cell = _grid[n];
+            if (cell.size() != 1) continue;
+            const int from = mobilityBucket(1, before);
+            const int to = mobilityBucket(1, before + delta);
+            if (from == to) continue;
+            auto& buckets = _eval.mobility[static_cast<int>(cell.top().color)];
+            --buckets[from];
+            ++buckets[to];
+        }
+    }
+
+    std::array<std::uint8_t, 2> Board::pinnedCounts() const {
+        std::array<std::uint8_t, 2> pinned = {0, 0};
+        // With one or two cells, no cell is a cut
+        if (_occupied_coords.size() < 3) return pinned;
+
+        std::array<int, PIECE_COUNT> order{};
+        int time = 0;
+        pinnedDfs(0, -1, order, time, pinned);
+        return pinned;
+    }
+
+    int Board::pinnedDfs(const int slot, const int parent, std::array<int, PIECE_COUNT>& order, int& time,
+                         std::array<std::uint8_t, 2>& pinned) const {
+        order[slot] = ++time;
+        int low = order[slot];
+        int children = 0;
+        bool cut = false;
+
+        const int idx = AxToIndex(_occupied_coords[slot]);
+        for (int offset : NEIGHBORS) {
+            const int next = _slots[idx + offset];
+            if (next < 0 || next == parent) continue;
+            if (order[next] != 0) {
+                low = std::min(low, order[next]);
+                continue;
+            }
+            const int childLow = pinnedDfs(next, slot, order, time, pinned);
+            low = std::min(low, childLow);
+            ++children;
+            // No back edge from the subtree of the child above this cell: removing it cuts the subtree off
+            if (parent >= 0 && childLow >= order[slot]) cut = true;
+        }
+        if (parent < 0 && children >= 2) cut = true;
+
+        if (cut && _grid[idx].size() == 1) ++pinned[static_cast<int>(_grid[idx].top().color)];
+        return low;
+    }
+
     void Board::getOccupiedNeighbors(const Coord coord, std::vector<Coord>& out) const {
         out.clear();
         const int centerIdx = AxToIndex(coord);
@@ -0,0 +1,220 @@
+#include "headers/book.h"
+#include "headers/alphabeta.h"
+#include "headers/symmetry.h"
+#include "headers/zobrist.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Hive {
+
+    namespace {
+        constexpr char MAGIC[4] = {'H', 'H', 'B', 'K'};
+        constexpr std::size_t HEADER_SIZE = 16;
+
+        std::optional<Color> winnerOf(const std::string& state) {
+            if (state == "WhiteWins") return Color::White;
+            if (state == "BlackWins") return Color::Black;
+            return std::nullopt;
+        }
+
+        // Runs body(thread, builder) on threads, each with its own builder, and merges them
+        template <typename Body>
+        BookBuilder buildInParallel(int maxPly, int threads, const Body& body) {
+            std::vector<BookBuilder> builders(static_cast<std::size_t>(std::max(threads, 1)), BookBuilder(maxPly));
+            std::vector<std::thread> pool;
+            for (std::size_t t = 0; t < builders.size(); ++t) {
+                pool.emplace_back([&body, &builders, t] { body(static_cast<int>(t), builders[t]); });
+            }
+            for (auto& t : pool) t.join();
+
+            for (std::size_t t = 1; t < builders.size(); ++t) builders[0].merge(builders[t]);
+            return std::move(builders[0]);
+        }
+    }
+
+    // ----- OpeningBook -----
+
+    OpeningBook::OpeningBook(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::invalid_argument("Cannot read book file: " + path);
+
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < HEADER_SIZE) {
+            ::close(fd);
+            throw std::invalid_argument("Not a book file: " + path);
+        }
+        mappingSize = static_cast<std::size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) throw std::invalid_argument("Cannot map book file: " + path);
+        mapping = mapped;
+
+        const auto* bytes = static_cast<const char*>(mapping);
+        std::uint32_t header[3];
+        std::memcpy(header, bytes + 4, sizeof(header));
+        std::string error;
+        if (!std::equal(bytes, bytes + 4, MAGIC)) error = "Not a book file: " + path;
+        else if (header[0] != VERSION) error = "Unsupported book version " + std::to_string(header[0]);
+        else if (mappingSize != HEADER_SIZE + header[1] * sizeof(Entry) + header[2] * sizeof(StoredMove)) error = "Truncated book file: " + path;
+        if (!error.empty()) {
+            ::munmap(mapping, mappingSize);
+            throw std::invalid_argument(error);
+        }
+
+        entryCount = header[1];
+        entries = reinterpret_cast<const Entry*>(bytes + HEADER_SIZE);
+        moves = reinterpret_cast<const StoredMove*>(bytes + HEADER_SIZE + entryCount * sizeof(Entry));
+        ::madvise(mapping, mappingSize, MADV_RANDOM);
+    }
+
+    OpeningBook::~OpeningBook() {
+        if (mapping) ::munmap(mapping, mappingSize);
+    }
+
+    std::vector<BookMove> OpeningBook::probe(const Position& pos) const {
+        const Canonical canonical = Canonicalize(pos);
+        const Entry* end = entries + entryCount;
+        const Entry* entry = std::lower_bound(entries, end, canonical.key,
+                                              [](const Entry& e, std::uint64_t key) { return e.key < key; });
+        if (entry == end || entry->key != canonical.key) return {};
+
+        std::vector<BookMove> found;
+        found.reserve(entry->moveCount);
+        for (std::uint32_t i = 0; i < entry->moveCount; ++i) {
+            const StoredMove& stored = moves[entry->firstMove + i];
+            found.push_back({canonical.undo(UnpackMove(stored.move)), stored.weight});
+        }
+        return found;
+    }
+
+    bool OpeningBook::pick(const Position& pos, const std::vector<Move>& legalMoves, std::mt19937_64& rng, Move& out) const {
+        std::vector<BookMove> candidates = probe(pos);
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](const BookMove& c) {
+            return std::find(legalMoves.begin(), legalMoves.end(), c.move) == legalMoves.end();
+        }), candidates.end());
+        if (candidates.empty()) return false;
+
+        std::uint64_t total = 0;
+        for (const auto& c : candidates) total += c.weight;
+        std::uint64_t draw = std::uniform_int_distribution<std::uint64_t>(0, total - 1)(rng);
+        for (const auto& c : candidates) {
+            if (draw < c.weight) {
+                out = c.move;
+                return true;
+            }
+            draw -= c.weight;
+        }
+        out = candidates.back().move;
+        return true;
+    }
+
+    // ----- BookBuilder -----
+
+    void BookBuilder::addGame(const std::vector<Move>& moves, std::optional<Color> winner) {
+        Position pos = Position::fromBoard(Board(), Color::White);
+        const std::size_t plies = std::min(moves.size(), static_cast<std::size_t>(maxPly));
+        for (std::size_t ply = 0; ply < plies; ++ply) {
+            const Move& move = moves[ply];
+            if (move.type != Move::Pass) {
+                const Canonical canonical = Canonicalize(pos);
+                table[canonical.key][PackMove(canonical.apply(move))] += (winner == pos.turnPlayer) ? 2 : 1;
+            }
+            pos.play(move);
+        }
+    }
+
+    void BookBuilder::merge(const BookBuilder& other) {
+        for (const auto& position : other.table) {
+            auto& counts = table[position.first];
+            for (const auto& move : position.second) counts[move.first] += move.second;
+        }
+    }
+
+    void BookBuilder::write(const std::string& path, std::uint32_t minWeight) const {
+        std::vector<std::uint64_t> keys;
+        keys.reserve(table.size());
+        for (const auto& position : table) keys.push_back(position.first);
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<OpeningBook::Entry> entries;
+        std::vector<OpeningBook::StoredMove> moves;
+        for (std::uint64_t key : keys) {
+            std::vector<OpeningBook::StoredMove> kept;
+            for (const auto& move : table.at(key)) {
+                if (move.second >= minWeight) kept.push_back({move.first, move.second});
+            }
+            if (kept.empty()) continue;
+            std::sort(kept.begin(), kept.end(), [](const OpeningBook::StoredMove& a, const OpeningBook::StoredMove& b) {
+                return a.weight != b.weight ? a.weight > b.weight : a.move < b.move;
+            });
+            entries.push_back({key, static_cast<std::uint32_t>(moves.size()), static_cast<std::uint32_t>(kept.size())});
+            moves.insert(moves.end(), kept.begin(), kept.end());
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) throw std::invalid_argument("Cannot write book file: " + path);
+        const std::uint32_t header[3] = {OpeningBook::VERSION, static_cast<std::uint32_t>(entries.size()), static_cast<std::uint32_t>(moves.size())};
+        out.write(MAGIC, 4);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(OpeningBook::Entry)));
+        out.write(reinterpret_cast<const char*>(moves.data()), static_cast<std::streamsize>(moves.size() * sizeof(OpeningBook::StoredMove)));
+        if (!out) throw std::invalid_argument("Cannot write book file: " + path);
+    }
+
+    BookBuilder BookBuilder::fromGames(const std::vector<Analysis::Game>& games, int maxPly, int threads) {
+        return buildInParallel(maxPly, threads, [&games, threads](int thread, BookBuilder& builder) {
+            for (std::size_t g = static_cast<std::size_t>(thread); g < games.size(); g += static_cast<std::size_t>(threads)) {
+                builder.addGame(games[g].moves, winnerOf(games[g].state));
+            }
+        });
+    }
+
+    BookBuilder BookBuilder::fromSelfPlay(int games, int depth, int randomPlies, int maxPly, int threads, std::uint64_t seed) {
+        return buildInParallel(maxPly, threads, [=](int thread, BookBuilder& builder) {
+            std::mt19937_64 rng(splitmix64(seed + static_cast<std::uint64_t>(thread)));
+            AlphaBetaEngine engine;
+            engine.setVerbose(false);
+            SearchLimits limits;
+            limits.moveTime = NO_TIME_LIMIT;
+            limits.depth = depth;
+            engine.setLimits(limits);
+
+            for (int g = thread; g < games; g += threads) {
+                engine.clear();
+                Position pos = Position::fromBoard(Board(), Color::White);
+                std::vector<Move> played;
+                std::optional<Color> winner;
+                for (int ply = 0; ply < maxPly; ++ply) {
+                    const std::vector<Move> legal = pos.generateMoves();
+                    Move move = PASS_MOVE;
+                    if (!legal.empty() && ply < randomPlies) {
+                        move = legal[std::uniform_int_distribution<std::size_t>(0, legal.size() - 1)(rng)];
+                    } else if (!legal.empty()) {
+                        engine.setGameKeys(pos.reversibleKeys());
+                        move = engine.getBestMove(pos.board, pos.turnPlayer, pos.hand(pos.turnPlayer), legal);
+                    }
+                    played.push_back(move);
+                    pos.play(move);
+
+                    const bool whiteSurrounded = pos.isQueenSurrounded(Color::White);
+                    const bool blackSurrounded = pos.isQueenSurrounded(Color::Black);
+                    if (whiteSurrounded || blackSurrounded) {
+                        if (whiteSurrounded != blackSurrounded) winner = whiteSurrounded ? Color::Black : Color::White;
+                        break;
+                    }
+                }
+                builder.addGame(played, winner);
+            }
+        });
+    }
+
+}
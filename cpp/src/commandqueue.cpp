@@ -0,0 +1,43 @@
+#include "headers/commandqueue.h"
+
+#include <thread>
+
+namespace Hive {
+
+    void CommandQueue::push(std::string line) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        while (t - head.load(std::memory_order_acquire) >= CAPACITY) std::this_thread::yield();
+
+        slots[t & (CAPACITY - 1)] = std::move(line);
+        tail.store(t + 1, std::memory_order_release);
+
+        // Taking the mutex orders the store before a consumer about to park: the wake-up is never lost
+        { std::lock_guard<std::mutex> lock(parking); }
+        wake.notify_one();
+    }
+
+    void CommandQueue::close() {
+        closed.store(true, std::memory_order_release);
+        { std::lock_guard<std::mutex> lock(parking); }
+        wake.notify_one();
+    }
+
+    bool CommandQueue::pop(std::string& line) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        auto ready = [&] {
+            return tail.load(std::memory_order_acquire) != h || closed.load(std::memory_order_acquire);
+        };
+        if (!ready()) {
+            std::unique_lock<std::mutex> lock(parking);
+            wake.wait(lock, ready);
+        }
+
+        // Closed: the lines pushed before close() are still delivered
+        if (tail.load(std::memory_order_acquire) == h) return false;
+
+        line = std::move(slots[h & (CAPACITY - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+}
@@ -0,0 +1,349 @@
+#include "headers/dfpn.h"
+#include "headers/alphabeta.h"
+#include "headers/utils.h"
+#include "headers/zobrist.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Hive {
+
+    namespace {
+        // Table key salts
+        constexpr std::uint64_t DEPTH_SALT = 1ULL << 42;
+        constexpr std::uint64_t ATTACKER_SALT = 1ULL << 43;
+        constexpr std::uint64_t LAST_MOVED_SALT = 1ULL << 44;
+
+        // Nodes between two clock checks
+        constexpr std::uint64_t TIME_CHECK_NODES = 1024;
+
+        constexpr int MAX_SOLVER_PLIES = 15;
+
+        std::uint32_t saturatedAdd(std::uint32_t a, std::uint32_t b) {
+            return std::min(a + b, DfpnSolver::INFINITE_PN);
+        }
+    }
+
+    // ----- Table -----
+
+    DfpnTable::DfpnTable(std::size_t sizeMB) {
+        resize(sizeMB);
+    }
+
+    void DfpnTable::resize(std::size_t sizeMB) {
+        const std::size_t bytes = std::max<std::size_t>(sizeMB, 1) << 20;
+        std::size_t count = 1;
+        while (count * 2 * BUCKET_SIZE * sizeof(Entry) <= bytes) count *= 2;
+
+        entries.reset(count * BUCKET_SIZE);
+        bucketCount = count;
+    }
+
+    void DfpnTable::clear() {
+        // An unmapped table starts empty
+        if (entries.allocated()) std::fill(entries.data(), entries.data() + entries.size(), Entry());
+    }
+
+    bool DfpnTable::probe(std::uint64_t key, std::uint32_t& pn, std::uint32_t& dn) const {
+        const Entry* bucket = &entries[(key & (bucketCount - 1)) * BUCKET_SIZE];
+        for (int i = 0; i < BUCKET_SIZE; ++i) {
+            if (bucket[i].work != 0 && bucket[i].key == key) {
+                pn = bucket[i].pn;
+                dn = bucket[i].dn;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void DfpnTable::store(std::uint64_t key, std::uint32_t pn, std::uint32_t dn, std::uint64_t work) {
+        Entry* bucket = &entries[(key & (bucketCount - 1)) * BUCKET_SIZE];
+        Entry* victim = &bucket[0];
+        for (int i = 0; i < BUCKET_SIZE; ++i) {
+            // Same position or free entry: take it. Otherwise replace the entry that was cheapest to compute
+            if (bucket[i].work == 0 || bucket[i].key == key) {
+                victim = &bucket[i];
+                break;
+            }
+            if (bucket[i].work < victim->work) victim = &bucket[i];
+        }
+        victim->key = key;
+        victim->pn = pn;
+        victim->dn = dn;
+        victim->work = std::max<std::uint64_t>(work, 1);
+    }
+
+    // ----- Solver -----
+
+    DfpnResult DfpnSolver::solve(const Position& pos, int maxPlies, std::uint64_t maxNodes, std::chrono::milliseconds maxTime) {
+        const auto start = std::chrono::steady_clock::now();
+        deadline = start + maxTime;
+        nodeLimit = maxNodes;
+        nodes = 0;
+        aborted = false;
+        maxPlies = std::clamp(maxPlies, 1, MAX_SOLVER_PLIES);
+        table.allocate();
+
+        DfpnResult result;
+        Position work = pos;
+
+        // Can the player to move force a surround? If not, can the rival, whatever the player to move does?
+        attacker = pos.turnPlayer;
+        if (prove(work, maxPlies)) {
+            result.proof = Proof::Win;
+            result.line = provenLine(pos, maxPlies);
+        } else if (!aborted) {
+            attacker = rival(pos.turnPlayer);
+            if (prove(work, maxPlies)) {
+                result.proof = Proof::Loss;
+                result.line = provenLine(pos, maxPlies);
+            }
+        }
+
+        result.aborted = aborted;
+        result.nodes = nodes;
+        result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        return result;
+    }
+
+    bool DfpnSolver::prove(Position& pos, int maxPlies) {
+        mid(pos, maxPlies, INFINITE_PN, INFINITE_PN);
+        std::uint32_t pn, dn;
+        return table.probe(keyOf(pos, maxPlies), pn, dn) && pn == 0;
+    }
+
+    void DfpnSolver::mid(Position& pos, int remaining, std::uint32_t thpn, std::uint32_t thdn) {
+        ++nodes;
+        const std::uint64_t startNodes = nodes;
+        const std::uint64_t key = keyOf(pos, remaining);
+
+        std::uint32_t pn = INFINITE_PN, dn = 0;
+        if (terminal(pos, pn, dn) || remaining == 0) {
+            // A surround, or out of plies without one
+            table.store(key, pn, dn, 1);
+            return;
+        }
+
+        std::vector<Child> children;
+        generateChildren(pos, remaining, children);
+        const bool orNode = (pos.turnPlayer == attacker);
+
+        // In the OR / AND symmetric form: the node takes the minimum of one number over its children (pn at OR nodes,
+        // dn at AND nodes) and the sum of the other
+        while (true) {
+            std::uint32_t minTerm = INFINITE_PN, secondTerm = INFINITE_PN, sumTerm = 0, bestSumTerm = 0;
+            std::size_t best = 0;
+            for (std::size_t i = 0; i < children.size(); ++i) {
+                std::uint32_t cpn, cdn;
+                lookup(children[i], cpn, cdn);
+                const std::uint32_t m = orNode ? cpn : cdn;
+                const std::uint32_t s = orNode ? cdn : cpn;
+                sumTerm = saturatedAdd(sumTerm, s);
+                if (m < minTerm) {
+                    secondTerm = minTerm;
+                    minTerm = m;
+                    best = i;
+                    bestSumTerm = s;
+                } else if (m < secondTerm) {
+                    secondTerm = m;
+                }
+            }
+            pn = orNode ? minTerm : sumTerm;
+            dn = orNode ? sumTerm : minTerm;
+
+            if (pn >= thpn || dn >= thdn || outOfBudget()) break;
+
+            // The best child is searched until it stops being the best (its minimum term passes the second best)
+            // or the node reaches its own threshold on the sum
+            const std::uint32_t thMin = orNode ? thpn : thdn;
+            const std::uint32_t thSum = orNode ? thdn : thpn;
+            const std::uint32_t childThMin = std::min(thMin, saturatedAdd(secondTerm, 1));
+            const std::uint32_t childThSum = std::min(INFINITE_PN, thSum - sumTerm + bestSumTerm);
+
+            pos.play(children[best].move);
+            mid(pos, remaining - 1, orNode ? childThMin : childThSum, orNode ? childThSum : childThMin);
+            pos.undo();
+        }
+
+        table.store(key, pn, dn, nodes - startNodes + 1);
+    }
+
+    void DfpnSolver::generateChildren(Position& pos, int remaining, std::vector<Child>& children) {
+        std::vector<Move> moves = pos.generateMoves();
+        if (moves.empty()) moves.push_back(PASS_MOVE);
+
+        children.clear();
+        children.reserve(moves.size());
+        for (const Move& move : moves) {
+            Child child;
+            child.move = move;
+            pos.play(move);
+            if (terminal(pos, child.pn, child.dn)) {
+                child.solved = true;
+            } else if (remaining == 1) {
+                // Out of plies without a surround: refuted
+                child.solved = true;
+                child.pn = INFINITE_PN;
+                child.dn = 0;
+            } else {
+                child.key = keyOf(pos, remaining - 1);
+            }
+            pos.undo();
+            children.push_back(child);
+        }
+    }
+
+    void DfpnSolver::lookup(const Child& child, std::uint32_t& pn, std::uint32_t& dn) const {
+        if (child.solved) {
+            pn = child.pn;
+            dn = child.dn;
+        } else if (!table.probe(child.key, pn, dn)) {
+            pn = 1;
+            dn = 1;
+        }
+    }
+
+    std::vector<Move> DfpnSolver::provenLine(Position pos, int maxPlies) {
+        std::vector<Move> line;
+        std::vector<Child> children;
+        for (int remaining = maxPlies; remaining > 0; --remaining) {
+            std::uint32_t pn, dn;
+            if (terminal(pos, pn, dn)) break;
+
+            generateChildren(pos, remaining, children);
+            const bool orNode = (pos.turnPlayer == attacker);
+
+            // The attacker surrounds at once when it can; the defender avoids an immediate surround when it can.
+            // A child missing from the table (replaced since) ends the line
+            const Child* pick = nullptr;
+            for (const Child& child : children) {
+                lookup(child, pn, dn);
+                if (pn != 0) continue;
+                if (pick == nullptr || (orNode ? child.solved && !pick->solved : !child.solved && pick->solved)) pick = &child;
+            }
+            if (pick == nullptr) break;
+
+            line.push_back(pick->move);
+            pos.play(pick->move);
+        }
+        return line;
+    }
+
+    std::uint64_t DfpnSolver::keyOf(const Position& pos, int remaining) const {
+        std::uint64_t key = pos.key() ^ splitmix64(DEPTH_SALT | static_cast<std::uint64_t>(remaining));
+        if (attacker == Color::Black) key ^= splitmix64(ATTACKER_SALT);
+        // The last moved piece restricts the Pillbug throws
+        if (pos.lastMoved) key ^= splitmix64(LAST_MOVED_SALT | static_cast<std::uint64_t>(pieceIndex(*pos.lastMoved)));
+        return key;
+    }
+
+    bool DfpnSolver::terminal(const Position& pos, std::uint32_t& pn, std::uint32_t& dn) const {
+        const bool attackerSurrounded = pos.isQueenSurrounded(attacker);
+        const bool defenderSurrounded = pos.isQueenSurrounded(rival(attacker));
+        if (!attackerSurrounded && !defenderSurrounded) return false;
+
+        // Both Queens surrounded is a draw: not what the attacker is after
+        const bool proven = defenderSurrounded && !attackerSurrounded;
+        pn = proven ? 0 : INFINITE_PN;
+        dn = proven ? INFINITE_PN : 0;
+        return true;
+    }
+
+    bool DfpnSolver::outOfBudget() {
+        if (aborted) return true;
+        if (nodeLimit != 0 && nodes >= nodeLimit) aborted = true;
+        if (nodes % TIME_CHECK_NODES == 0 && std::chrono::steady_clock::now() >= deadline) aborted = true;
+        return aborted;
+    }
+
+    void ReportSolve(const DfpnResult& result, const Position& pos, int maxPlies) {
+        static const char* const NAMES[] = {"unknown", "win", "loss"};
+        std::cerr << "info solver " << NAMES[static_cast<int>(result.proof)] << " plies " << maxPlies
+                  << " nodes " << result.nodes << " time " << result.time.count();
+        if (result.aborted) std::cerr << " aborted";
+        if (!result.line.empty()) {
+            std::cerr << " line ";
+            Position p = pos;
+            for (size_t i = 0; i < result.line.size(); ++i) {
+                std::cerr << (i > 0 ? ";" : "") << MoveToString(result.line[i], p.board);
+                p.play(result.line[i]);
+            }
+        }
+        std::cerr << std::endl;
+    }
+
+    // ----- Engine -----
+
+    DfpnEngine::DfpnEngine() : solver(DfpnTable::DEFAULT_SIZE_MB), fallback(std::make_unique<AlphaBetaEngine>()) {
+        // The position has just been solved: the fallback does not try again
+        fallback->setOption("Solver", "False");
+    }
+
+    DfpnEngine::~DfpnEngine() = default;
+
+    Move DfpnEngine::getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) {
+        if (validMoves.empty()) return PASS_MOVE;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (solver.allocate()) std::cerr << PagesInfo("solver", solver.sizeMB(), solver.backing()) << std::endl;
+        const Position pos = Position::fromBoard(board, turnPlayer);
+        // A search bounded by depth only gives the solver its share of the default move time, the depth goes to the fallback
+        const bool timed = limits.moveTime < NO_TIME_LIMIT;
+        result = solver.solve(pos, maxPlies, 0, (timed ? limits.moveTime : DEFAULT_MOVE_TIME) * timeShare / 100);
+        ReportSolve(result, pos, maxPlies);
+
+        // The board alone does not tell the last moved piece: a line starting with a throw it forbids is not played
+        if (result.proof != Proof::Unknown && !result.line.empty()
+            && std::find(validMoves.begin(), validMoves.end(), result.line.front()) != validMoves.end()) {
+            return result.line.front();
+        }
+
+        SearchLimits rest = limits;
+        if (timed) {
+            const auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            rest.moveTime = std::max(limits.moveTime - spent, std::chrono::milliseconds(1));
+        }
+        fallback->setLimits(rest);
+        return fallback->getBestMove(board, turnPlayer, hand, validMoves);
+    }
+
+    std::vector<EngineOption> DfpnEngine::getOptions() const {
+        std::vector<EngineOption> options = {
+            {"SolverPlies", "int", std::to_string(maxPlies), "7", {"1", std::to_string(MAX_SOLVER_PLIES)}},
+            {"SolverTimeShare", "int", std::to_string(timeShare), "50", {"1", "100"}},
+            {"SolverHashMB", "int", std::to_string(hashMB), std::to_string(DfpnTable::DEFAULT_SIZE_MB), {"1", "65536"}}
+        };
+        for (auto& option : fallback->getOptions()) {
+            if (option.name != "Solver") options.push_back(std::move(option));
+        }
+        return options;
+    }
+
+    bool DfpnEngine::setOption(const std::string& name, const std::string& value) {
+        try {
+            if (name == "SolverPlies") {
+                const int plies = std::stoi(value);
+                if (plies < 1 || plies > MAX_SOLVER_PLIES) return false;
+                maxPlies = plies;
+                return true;
+            }
+            if (name == "SolverTimeShare") {
+                const int share = std::stoi(value);
+                if (share < 1 || share > 100) return false;
+                timeShare = share;
+                return true;
+            }
+            if (name == "SolverHashMB") {
+                const int mb = std::stoi(value);
+                if (mb < 1 || mb > 65536) return false;
+                hashMB = static_cast<std::size_t>(mb);
+                solver.resize(hashMB);
+                return true;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return name != "Solver" && fallback->setOption(name, value);
+    }
+
+}
@@ -1,4 +1,5 @@
 #include "headers/engine.h"
+#include "headers/timeman.h"
 #include <chrono>
 #include <thread>
 #include <random>
@@ -8,20 +9,18 @@ namespace Hive {
     Move RandomEngine::getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) {
         if (validMoves.empty()) {
             // Return a pass move if absolutely no moves are available
-            return {Move::Pass, {Color::White, Bug::Ant, 0}, {0,0}, {0,0}};
+            return PASS_MOVE;
         }
 
-        // Enforce the strict 5-second constraint
-        auto timeLimit = std::chrono::seconds(5);
-        auto startTime = std::chrono::steady_clock::now();
-
-        while (true) {
-            auto currentTime = std::chrono::steady_clock::now();
-            if (currentTime - startTime >= timeLimit) {
-                break;
+        // Enforce the time constraint of the move, minus the reply margin (see timeman.h).
+        // A search bounded by depth only does not wait
+        TimeManager clock;
+        clock.start(limits);
+        if (clock.timed()) {
+            while (std::chrono::steady_clock::now() < clock.hardDeadline()) {
+                // Yield the thread to prevent 100% CPU lockup during the waiting period
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
             }
-            // Yield the thread to prevent 100% CPU lockup during the waiting period
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
 
         // Initialize random number generator
@@ -0,0 +1,147 @@
+#include "headers/eval.h"
+#include "headers/rules.h"
+
+#include <bitset>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Hive {
+
+    namespace {
+        EvalWeights activeWeights;
+        std::uint32_t weightsGeneration = 0;
+
+        // Reads exactly N integers from the rest of a weights file line
+        template <std::size_t N>
+        void readValues(std::istringstream& in, std::array<int, N>& values, const std::string& name) {
+            for (int& v : values) {
+                if (!(in >> v)) throw std::invalid_argument("Expected " + std::to_string(N) + " values for " + name);
+            }
+            std::string extra;
+            if (in >> extra) throw std::invalid_argument("Too many values for " + name);
+        }
+
+        void readValue(std::istringstream& in, int& value, const std::string& name) {
+            std::array<int, 1> values{};
+            readValues(in, values, name);
+            value = values[0];
+        }
+
+        // Pieces of a bug in a hand mask
+        int handCount(std::uint16_t hand, int bug) {
+            const unsigned bugMask = (1u << BUG_COUNT[bug]) - 1u;
+            return static_cast<int>(std::bitset<16>((hand >> BUG_OFFSET[bug]) & bugMask).count());
+        }
+
+        // Liberties of the Queen of a player, 6 if not placed
+        int queenLiberties(const Board& board, Color player) {
+            Coord queen;
+            if (!board.locate({player, Bug::Queen, 0}, queen)) return 6;
+            return 6 - board.occupiedNeighbors(queen);
+        }
+    }
+
+    const EvalWeights& ActiveEvalWeights() {
+        return activeWeights;
+    }
+
+    std::uint32_t EvalWeightsGeneration() {
+        return weightsGeneration;
+    }
+
+    void SetEvalWeights(const EvalWeights& weights) {
+        activeWeights = weights;
+        ++weightsGeneration;
+    }
+
+    EvalWeights LoadEvalWeights(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) throw std::invalid_argument("Cannot read weights file: " + path);
+
+        EvalWeights weights;
+        std::string line;
+        while (std::getline(file, line)) {
+            const std::size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            std::istringstream in(line);
+            std::string name;
+            if (!(in >> name)) continue;
+
+            if (name == "queen_liberties") readValues(in, weights.queenLiberties, name);
+            else if (name == "pinned") readValue(in, weights.pinned, name);
+            else if (name == "climber") readValue(in, weights.climber, name);
+            else if (name == "covered") readValue(in, weights.covered, name);
+            else if (name == "mobility") readValues(in, weights.mobility, name);
+            else if (name == "hand") readValues(in, weights.hand, name);
+            else if (name == "tempo") readValue(in, weights.tempo, name);
+            else throw std::invalid_argument("Unknown weight: " + name);
+        }
+        return weights;
+    }
+
+    int Evaluate(const Position& pos, const EvalWeights& weights) {
+        const Board& board = pos.board;
+#ifdef HIGH_HIVE_VERIFY_EVAL
+        assert(VerifyEvalTerms(board) && "Evaluation counters out of sync with the board");
+#endif
+
+        const EvalTerms& terms = board.evalTerms();
+        const std::array<std::uint8_t, 2> pinned = board.pinnedCounts();
+        int score = 0;  // White's point of view
+        for (int c = 0; c < 2; ++c) {
+            int side = weights.queenLiberties[queenLiberties(board, static_cast<Color>(c))];
+            side += weights.pinned * pinned[c];
+            side += weights.climber * terms.climbers[c];
+            side += weights.covered * terms.covered[c];
+            for (int b = 0; b < MOBILITY_BUCKETS; ++b) side += weights.mobility[b] * terms.mobility[c][b];
+            for (int bug = 0; bug < static_cast<int>(weights.hand.size()); ++bug) side += weights.hand[bug] * handCount(pos.hands[c], bug);
+            score += (c == 0) ? side : -side;
+        }
+
+        return ((pos.turnPlayer == Color::White) ? score : -score) + weights.tempo;
+    }
+
+    EvalTerms RecomputeEvalTerms(const Board& board) {
+        EvalTerms terms;
+        for (const Coord& c : board.occupiedCoords()) {
+            const Board::Cell& cell = board.cell(c);
+            for (int level = 0; level < cell.size(); ++level) {
+                const Piece& p = cell._data[level];
+                ++terms.onBoard[static_cast<int>(p.color)][static_cast<int>(p.bug)];
+                if (level > 0) ++terms.climbers[static_cast<int>(p.color)];
+                if (level < cell.size() - 1) ++terms.covered[static_cast<int>(p.color)];
+            }
+
+            int occupied = 0;
+            for (const Coord& n : coordNeighbors(c)) {
+                if (!board.empty(n)) ++occupied;
+            }
+            ++terms.mobility[static_cast<int>(cell.top().color)][mobilityBucket(cell.size(), occupied)];
+        }
+        return terms;
+    }
+
+    std::array<std::uint8_t, 2> RecountPinned(const Board& board) {
+        std::array<std::uint8_t, 2> pinned = {0, 0};
+        for (const Coord& c : board.occupiedCoords()) {
+            if (board.height(c) == 1 && !RuleEngine::canLift(board, c)) ++pinned[static_cast<int>(board.top(c)->color)];
+        }
+        return pinned;
+    }
+
+    bool VerifyEvalTerms(const Board& board) {
+        for (const Coord& c : board.occupiedCoords()) {
+            for (const Coord& n : coordNeighbors(c)) {
+                int occupied = 0;
+                for (const Coord& m : coordNeighbors(n)) {
+                    if (!board.empty(m)) ++occupied;
+                }
+                if (board.occupiedNeighbors(n) != occupied) return false;
+            }
+        }
+        return board.evalTerms() == RecomputeEvalTerms(board) && board.pinnedCounts() == RecountPinned(board);
+    }
+
+}
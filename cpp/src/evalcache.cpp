@@ -0,0 +1,86 @@
+#include "headers/evalcache.h"
+#include "headers/eval.h"
+#include "headers/nnue.h"
+
+#include <algorithm>
+
+namespace Hive {
+
+    namespace {
+        constexpr std::uint64_t STORED_BIT = 1ull << 63;
+
+        std::uint64_t mix(std::uint64_t x) {
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+    }
+
+    EvalCache::EvalCache(std::size_t sizeMB) {
+        resize(sizeMB);
+    }
+
+    void EvalCache::resize(std::size_t sizeMB) {
+        std::size_t count = 0;
+        if (sizeMB > 0) {
+            const std::size_t bytes = sizeMB << 20;
+            count = 1;
+            while (count * 2 * sizeof(Entry) <= bytes) count *= 2;
+        }
+
+        if (count != entryCount) {
+            entries.reset(count);
+            entryCount = count;
+        }
+        clear();
+    }
+
+    void EvalCache::clear() {
+        // An unmapped cache starts empty
+        for (std::size_t i = 0; entries.allocated() && i < entryCount; ++i) {
+            entries[i].keyXorData.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+        stats.probes.store(0, std::memory_order_relaxed);
+        stats.hits.store(0, std::memory_order_relaxed);
+    }
+
+    bool EvalCache::probe(std::uint64_t key, int& score) {
+        if (entryCount == 0) return false;
+        const bool counted = SampleProbe();
+        if (counted) stats.probes.fetch_add(1, std::memory_order_relaxed);
+
+        const Entry& e = entries[key & (entryCount - 1)];
+        const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        const std::uint64_t keyXorData = e.keyXorData.load(std::memory_order_relaxed);
+        if (data == 0 || (keyXorData ^ data) != key) return false;
+
+        score = static_cast<std::int16_t>(static_cast<std::uint16_t>(data));
+        if (counted) stats.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void EvalCache::store(std::uint64_t key, int score) {
+        if (entryCount == 0) return;
+
+        const std::uint64_t data = static_cast<std::uint64_t>(static_cast<std::uint16_t>(static_cast<std::int16_t>(std::clamp(score, -32767, 32767))))
+                                 | STORED_BIT;
+
+        Entry& e = entries[key & (entryCount - 1)];
+        e.keyXorData.store(key ^ data, std::memory_order_relaxed);
+        e.data.store(data, std::memory_order_relaxed);
+    }
+
+    int EvalCache::hitRate() const {
+        const std::uint64_t p = stats.probes.load(std::memory_order_relaxed);
+        return p == 0 ? 0 : static_cast<int>(stats.hits.load(std::memory_order_relaxed) * 1000 / p);
+    }
+
+    std::uint64_t EvalCacheKey(const Position& pos) {
+        const std::uint64_t evaluator = ActiveNetwork() != nullptr
+            ? (static_cast<std::uint64_t>(NetworkGeneration()) << 32) | 1u
+            : static_cast<std::uint64_t>(EvalWeightsGeneration()) << 1;
+        return pos.key() ^ mix(evaluator);
+    }
+
+}
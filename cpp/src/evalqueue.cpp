@@ -0,0 +1,91 @@
+#include "headers/evalqueue.h"
+
+#include <algorithm>
+
+namespace Hive {
+
+    void SequentialBatchEvaluator::evaluateBatch(const std::vector<EvalRequest*>& batch) {
+        for (EvalRequest* r : batch) {
+            r->value = leaf.evaluate(*r->pos, *r->moves, *r->priors);
+        }
+    }
+
+    EvalQueue::EvalQueue(BatchEvaluator& evaluator, int maxBatch, std::chrono::microseconds maxLatency)
+        : evaluator(evaluator),
+          maxBatch(static_cast<std::size_t>(std::max(maxBatch, 1))),
+          maxLatency(maxLatency),
+          created(std::chrono::steady_clock::now()) {
+        pending.reserve(this->maxBatch);
+        thread = std::thread([this] { service(); });
+    }
+
+    EvalQueue::~EvalQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeService.notify_one();
+        thread.join();
+    }
+
+    float EvalQueue::evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors) {
+        EvalRequest request;
+        request.pos = &pos;
+        request.moves = &moves;
+        request.priors = &priors;
+        request.submitted = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        pending.push_back(&request);
+        // The service sleeps until the first request, then until the batch is full
+        if (pending.size() == 1 || pending.size() >= maxBatch) wakeService.notify_one();
+        batchDone.wait(lock, [&] { return request.done; });
+        return request.value;
+    }
+
+    void EvalQueue::service() {
+        std::vector<EvalRequest*> batch;
+        batch.reserve(maxBatch);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeService.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break;  // Stopping
+
+            // Flush on a full batch or once the oldest request has waited long enough
+            const auto flushAt = pending.front()->submitted + maxLatency;
+            wakeService.wait_until(lock, flushAt, [&] { return stopping || pending.size() >= maxBatch; });
+
+            const std::size_t count = std::min(pending.size(), maxBatch);
+            batch.assign(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(count));
+            pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(count));
+
+            lock.unlock();
+            evaluator.evaluateBatch(batch);
+            const auto now = std::chrono::steady_clock::now();
+            lock.lock();
+
+            for (EvalRequest* r : batch) {
+                totalLatency += std::chrono::duration_cast<std::chrono::microseconds>(now - r->submitted);
+                r->done = true;
+            }
+            ++batches;
+            evaluations += count;
+            batchDone.notify_all();
+        }
+    }
+
+    EvalQueueStats EvalQueue::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        EvalQueueStats s;
+        s.batches = batches;
+        s.evaluations = evaluations;
+        if (batches > 0) s.averageBatch = static_cast<double>(evaluations) / static_cast<double>(batches);
+        if (evaluations > 0) s.averageLatencyUs = static_cast<double>(totalLatency.count()) / static_cast<double>(evaluations);
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+        if (elapsed > 0.0) s.evalsPerSecond = static_cast<double>(evaluations) / elapsed;
+        return s;
+    }
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "dfpn.h"
+#include "engine.h"
+#include "evalcache.h"
+#include "position.h"
+#include "timeman.h"
+#include "tt.h"
+#include "movepick.h"
+
+// ALPHA-BETA ENGINE
+// Iterative deepening over a Principal Variation Search (negamax form).
+// The search works on a single Position with make/unmake (Position::play / Position::undo):
+// the 4096-cell board is copied once per bestmove, never per node.
+// Scores are from the point of view of the player to move.
+// Searched positions are cached in a TranspositionTable, sized by the "HashSizeMB" option, and their static
+// evaluations in an EvalCache, sized by the "EvalCacheMB" option (0 turns it off).
+// Moves are ordered by a MovePicker; quiet placements far from both Queens are searched with
+// late move reductions. The "Ordering" option turns off both, for comparison.
+// Leaves are extended by a quiescence search over the moves that change a Queen surround, so the
+// evaluation is never taken in the middle of a surround fight (e.g. a Queen with one free neighbor left).
+//
+// Time: the iterative deepening ends at the soft deadline of a TimeManager (see timeman.h), and its Watchdog
+// stops the search at the hard deadline. A search bounded by depth only (NO_TIME_LIMIT) has no watchdog.
+//
+// Solver: when a Queen has at least 4 occupied neighbors, the position is first given to the df-pn solver
+// (see dfpn.h) for a short budget. A proven surround is played at once with its line as principal variation.
+// The "Solver" option turns it off.
+//
+// Repetitions: the root Position carries the keys of the game since its last placement (Engine::setGameKeys).
+// A position met again after the root, or for the third time in the game, is a draw (see
+// Position::isRepetitionDraw): lines that shuffle pieces back and forth end there instead of burning nodes.
+//
+// Symmetry: root moves that lead to symmetric images of the same position (see symmetry.h) are searched once,
+// which divides the opening branching factor. The "Symmetry" option turns it off.
+//
+// Lazy SMP: with "Threads" > 1, helper threads run the same iterative deepening on the same root,
+// skipping some depths so that threads spread over different depths. They only communicate through
+// the shared TranspositionTable and the stop flag. At the end, threads vote for the final move
+// weighting each best move by its score and completed depth.
+
+namespace Hive {
+
+    constexpr int INF_SCORE = 32000;
+    constexpr int MATE_SCORE = 30000;   // Score of a surrounded rival Queen at ply 0
+    constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+    constexpr int DRAW_SCORE = 0;
+
+    // Outcome of the last getBestMove
+    struct SearchResult {
+        Move move = PASS_MOVE;
+        int score = 0;
+        int depth = 0;                  // Last depth completed by the thread that gave the move
+        std::uint64_t nodes = 0;        // All threads
+        std::chrono::milliseconds time{0};
+        std::vector<Move> pv;
+    };
+
+    class AlphaBetaEngine : public Engine {
+    public:
+        static constexpr int MAX_THREADS = 256;
+
+        Move getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) override;
+
+        std::vector<EngineOption> getOptions() const override;
+        bool setOption(const std::string& name, const std::string& value) override;
+
+        void stop() override {
+            Engine::stop();
+            stopped = true;
+        }
+
+        bool canPonder() const override {
+            return true;
+        }
+
+        const SearchResult& lastResult() const {
+            return result;
+        }
+
+        // Clears the transposition table, the evaluation cache and the root solver table
+        void clear() {
+            tt.clear();
+            evalCache.clear();
+            solver.clear();
+        }
+
+        // Enables the per-iteration "info" lines on stderr
+        void setVerbose(bool enabled) {
+            verbose = enabled;
+        }
+
+    private:
+        // Per-thread search state. Workers share the engine's TranspositionTable and stop flag
+        struct Worker {
+            int id = 0;
+            Position pos;
+            std::vector<Move> rootMoves;
+
+            // Written by the owner only, read by the main thread for reports
+            std::atomic<std::uint64_t> nodes{0};
+
+            Move bestMove = PASS_MOVE;
+            int bestScore = 0;
+            int completedDepth = 0;
+
+            // Killers, history and countermoves, private to the thread
+            OrderingTables tables;
+
+            // Triangular principal variation table
+            std::array<std::array<Move, MAX_PLY>, MAX_PLY> pvTable;
+            std::array<int, MAX_PLY> pvLength{};
+        };
+
+        // Iterative deepening loop of a worker, until the depth limit or the stop flag
+        void iterativeDeepening(Worker& w);
+
+        // Searches all the root moves at a given depth. Returns the score of the best one
+        int searchRoot(Worker& w, int depth);
+
+        // Negamax PVS. Returns the score of w.pos searched at the given depth
+        int search(Worker& w, int depth, int alpha, int beta, int ply);
+
+        // Quiescence search at the leaves: only moves that change a Queen surround (Position::generateQueenThreats),
+        // until the position is quiet or MAX_QUIESCENCE_DEPTH plies of threats have been searched
+        int quiescence(Worker& w, int alpha, int beta, int ply, int qdepth);
+
+        // Static evaluation of pos for the player to move: the network if one is loaded (see nnue.h),
+        // the handcrafted evaluation otherwise (see eval.h), through the evaluation cache
+        int evaluate(const Position& pos);
+
+        // Picks the final move among the workers' best moves
+        const Worker& vote() const;
+
+        // Prints "info" statistics of a completed iteration to stderr
+        void report(Worker& w, int depth, int score) const;
+
+        std::uint64_t totalNodes() const;
+
+        std::chrono::milliseconds elapsed() const {
+            return timeManager.elapsed();
+        }
+
+        // Mate scores are stored relative to the node, not to the root
+        static int scoreToTT(int score, int ply);
+        static int scoreFromTT(int score, int ply);
+
+        // Plays a proven surround of the root, if the solver finds one. Returns False otherwise
+        bool solveRoot(const Position& root, const std::vector<Move>& validMoves);
+
+        TranspositionTable tt;
+        EvalCache evalCache;
+        DfpnSolver solver;
+        int threadCount = 1;
+        bool verbose = true;
+        bool ordering = true;   // Killers, history, countermoves and late move reductions
+        bool useSolver = true;
+        bool symmetry = true;   // Root moves collapsed by symmetry (see symmetry.h)
+
+        // ----- Search State -----
+        TimeManager timeManager;
+        std::atomic<bool> stopped{false};
+        int maxDepth = MAX_PLY - 1;
+        std::vector<std::unique_ptr<Worker>> workers;
+        SearchResult result;
+    };
+
+}
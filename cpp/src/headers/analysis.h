@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "moves.h"
+
+// BATCH ANALYSIS
+// Offline review of a corpus of games, outside the UHP loop: every position of every game (the position
+// before each recorded move) gets the same fixed-budget search, the positions spread over a pool of threads.
+// Each thread owns a single-threaded AlphaBetaEngine, cleared before each position (transposition table,
+// evaluation cache and root solver table), so that a depth-bounded analysis gives the same results, time_ms
+// aside, whatever the thread count and the order the positions are picked in.
+//
+// Input: one UHP GameString per line (e.g. "Base+MLP;InProgress;White[3];wS1;bG1 -wS1;wA1 wS1-"). Blank
+// lines and lines starting with '#' are skipped; a game with an unknown GameType or GameState, or a malformed or
+// illegal move, is reported and skipped.
+// Output: a tab-separated table with a header row, one row per position, in game then ply order:
+//     game  ply  turn  played  best  score  depth  nodes  time_ms  pv
+// where game is the line number in the input, score is for the player to move in centi-pieces, and pv is
+// ';' separated UHP MoveStrings.
+// Reached through the high_hive_analyze executable (see analyze.cpp).
+
+namespace Hive::Analysis {
+
+    struct Settings {
+        int threads = 1;
+        int depth = 4;                              // Used when moveTime is 0
+        std::chrono::milliseconds moveTime{0};      // Per position; 0 for a depth-bounded search
+        std::size_t hashMB = 16;                    // Transposition table of each thread
+    };
+
+    // A game of the corpus, its moves checked by a replay
+    struct Game {
+        int line = 0;
+        std::string state;                  // UHP GameStateString, e.g. "WhiteWins"
+        std::vector<std::string> moveStrings;
+        std::vector<Move> moves;
+    };
+
+    // Search of the position before a move
+    struct PlyResult {
+        std::string turn;                   // UHP TurnString, e.g. "White[3]"
+        std::string best;
+        int score = 0;
+        int depth = 0;
+        std::uint64_t nodes = 0;
+        std::chrono::milliseconds time{0};
+        std::string pv;
+    };
+
+    // Reads a file of GameStrings (see the format above). Games that do not replay are reported to log.
+    // Throws std::invalid_argument if the file cannot be read
+    std::vector<Game> readGames(const std::string& path, std::ostream& log);
+
+    // Analyzes every position of the games. Returns one result per move, in game then ply order.
+    // Reports the progress, positions per second and the time left, to log about once per second
+    std::vector<std::vector<PlyResult>> analyze(const std::vector<Game>& games, const Settings& settings, std::ostream& log);
+
+    // Writes the table (see the format above)
+    void writeResults(std::ostream& out, const std::vector<Game>& games, const std::vector<std::vector<PlyResult>>& results);
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// BENCHMARKS
+// A fixed set of positions (see position.h for the notation), from the opening to the late midgame,
+// searched with a fixed budget to measure engine changes on equal terms.
+// Reached through the UHP extension command "bench <name> [args]".
+
+namespace Hive::Bench {
+
+    // The benchmark positions
+    const std::vector<std::string>& positions();
+
+    // Lazy SMP scaling: every position searched to a fixed depth with 1, 2, 4, ... maxThreads threads.
+    // Reports nodes, nps and time-to-depth speedup against the single thread run
+    void smp(std::ostream& out, int depth, int maxThreads);
+
+    // Move ordering: nodes-to-depth of every position, single thread, with and without
+    // killers, history, countermoves and late move reductions (the "Ordering" option)
+    void ordering(std::ostream& out, int depth);
+
+    // MCTS tree parallelism at 1, 4, 16 and 32 threads (up to maxThreads): playouts per second with every
+    // position searched for moveTimeMs on a fresh tree, then, if games > 0, the score of that many games
+    // against the single thread engine at the same move time, starting from the benchmark positions
+    void mcts(std::ostream& out, int moveTimeMs, int maxThreads, int games);
+
+    // MCTS tree against graph search ("GraphSearch"): every position searched for a fixed number of
+    // playouts, reporting evaluations, distinct positions in the tree and evaluations per position
+    void graph(std::ostream& out, int playouts);
+
+    // MCTS with and without progressive widening ("Widening"): every position searched for a fixed number of
+    // playouts, reporting time, edges allocated and the visits of the chosen move
+    void widening(std::ostream& out, int playouts);
+
+    // Random playouts: every position played out a fixed number of times by generating all the moves and
+    // picking one, then by the RolloutPolicy sampler, uniform and with an attack weight. Reports playouts and
+    // moves per second, and the share of playouts that ended on a surround
+    void rollout(std::ostream& out, int playouts);
+
+    // Network evaluation with random weights (see nnue.h): every position's children played, evaluated and
+    // undone evals times, with the handcrafted evaluation, the network over the incremental accumulator and
+    // the network over an accumulator computed from scratch. Reports evaluations per second and the
+    // incremental evaluations that differ from the scratch ones (there should be none)
+    void nnue(std::ostream& out, int evals);
+
+    // Root move symmetry (see symmetry.h): the empty board, the first reply and every position, with their
+    // legal moves, the moves left once symmetric equivalents are collapsed, and the nodes-to-depth of a single
+    // thread search with and without the "Symmetry" option. Positions are numbered from the empty board (0)
+    void symmetry(std::ostream& out, int depth);
+
+}
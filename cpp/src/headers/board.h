@@ -8,6 +8,8 @@
 
 #include "coords.h"
 #include "pieces.h"
+#include "zobrist.h"
+#include "nnue.h"
 
 // CELL and BOARD IMPLEMENTATION
 // The board is implemented as a 1D array of dimension BOARD_AREA, where each cell is a stack of pieces (CellStack).
@@ -20,6 +22,35 @@ namespace Hive {
     constexpr int BOARD_OFFSET = BOARD_DIM / 2; // Offset for dealing with coordinates
     constexpr int BOARD_AREA = BOARD_DIM * BOARD_DIM; // Total grid area
     constexpr int MAX_STACK = 6; // To bound the height of the cells. Actually, heights > 4 are quite rare
+    constexpr int MOBILITY_BUCKETS = 3; // Trapped, crowded, free (see EvalTerms)
+
+    // EVALUATION TERMS
+    // Per color counters of the handcrafted evaluation (see eval.h), kept up to date by Board::place and Board::remove
+    // so that the evaluation never scans the grid. Queen liberties come from the occupied neighbor counts of the board.
+    // The pinned pieces are the exception: any move can change them anywhere in the hive, so Board::pinnedCounts
+    // computes them on demand over the occupied cells, once per evaluation instead of twice per move.
+    struct EvalTerms {
+        std::array<std::array<std::uint8_t, 8>, 2> onBoard{};   // Pieces on the board, by Bug enum order
+        std::array<std::uint8_t, 2> climbers{};                 // Pieces above the ground
+        std::array<std::uint8_t, 2> covered{};                  // Pieces under another piece
+        // Pieces on top of a stack by mobility bucket: 0 trapped on the ground (5+ occupied neighbors, no slide out),
+        // 1 crowded on the ground (3-4), 2 free (0-2 on the ground, or up on a stack)
+        std::array<std::array<std::uint8_t, MOBILITY_BUCKETS>, 2> mobility{};
+
+        friend bool operator == (const EvalTerms& a, const EvalTerms& b) {
+            return a.onBoard == b.onBoard && a.climbers == b.climbers && a.covered == b.covered &&
+                   a.mobility == b.mobility;
+        }
+        friend bool operator != (const EvalTerms& a, const EvalTerms& b) {
+            return !(a == b);
+        }
+    };
+
+    // Mobility bucket of the top piece of a stack of a given height with occupiedNeighbors occupied neighbors
+    constexpr int mobilityBucket(int height, int occupiedNeighbors) {
+        if (height > 1 || occupiedNeighbors <= 2) return 2;
+        return occupiedNeighbors >= 5 ? 0 : 1;
+    }
 
     // CELL
     template <typename Piece, int N>
@@ -106,6 +137,19 @@ namespace Hive {
             std::array<Cell, BOARD_AREA> _grid;
             // Occupied Coordinates
             std::vector<Coord> _occupied_coords;
+            // Grid index of every piece (see pieceIndex), -1 if the piece is not on the board
+            std::array<int, PIECE_COUNT> _piece_cells;
+            // Zobrist key of the pieces on the board, updated by place and remove
+            std::uint64_t _key = 0;
+            // Number of occupied neighbors of every cell, empty ones included
+            std::array<std::uint8_t, BOARD_AREA> _occupied_neighbors{};
+            // Position of every occupied cell in _occupied_coords, -1 if empty
+            std::array<std::int8_t, BOARD_AREA> _slots;
+            // Evaluation counters, updated by place and remove
+            EvalTerms _eval;
+            // First layer of the active network (see nnue.h), updated by place and remove unless paused
+            NnueAccumulator _nnue;
+            bool _nnue_paused = false;
 
             // Tile Neighbors
             // Is the (negative) difference between a hypothetical piece (q, r) and its neighbors
@@ -122,6 +166,8 @@ namespace Hive {
             // Reserve memory for each of the 28 cells
             Board() : _grid() {
             _occupied_coords.reserve(32);
+            _piece_cells.fill(-1);
+            _slots.fill(-1);
         }
 
 
@@ -131,6 +177,10 @@ namespace Hive {
                 return (coord.r + BOARD_OFFSET) * BOARD_DIM  + (coord.q + BOARD_OFFSET);
             }
 
+            [[nodiscard]] static inline Coord IndexToAx(int idx) {
+                return {idx % BOARD_DIM - BOARD_OFFSET, idx / BOARD_DIM - BOARD_OFFSET};
+            }
+
             [[nodiscard]] static inline bool isValid(Coord coord) {
                 int q = coord.q + BOARD_OFFSET;
                 int r = coord.r + BOARD_OFFSET;
@@ -162,6 +212,59 @@ namespace Hive {
                 return _grid[AxToIndex(coord)].empty();
             }
 
+            // Get the Coordinate of a piece, covered pieces included.
+            // Returns False if the piece is not on the board
+            bool locate(const Piece& piece, Coord& outCoord) const {
+                const int idx = _piece_cells[pieceIndex(piece)];
+                if (idx < 0) return false;
+                outCoord = IndexToAx(idx);
+                return true;
+            }
+
+            // Is the piece on the board
+            bool contains(const Piece& piece) const {
+                return _piece_cells[pieceIndex(piece)] >= 0;
+            }
+
+            // Get the Zobrist key of the pieces on the board (see zobrist.h)
+            std::uint64_t key() const {
+                return _key;
+            }
+
+            // Get the whole stack over a given Coordinate, from bottom to top
+            const Cell& cell(Coord coord) const {
+                return _grid[AxToIndex(coord)];
+            }
+
+            // Get the number of occupied neighbors of a Coordinate
+            int occupiedNeighbors(Coord coord) const {
+                return _occupied_neighbors[AxToIndex(coord)];
+            }
+
+            // Get the evaluation counters (see EvalTerms)
+            const EvalTerms& evalTerms() const {
+                return _eval;
+            }
+
+            // Get the number of pinned pieces of each color: single pieces on a cut cell of the hive (articulation
+            // points, Tarjan), that cannot move without splitting it. Runs over the occupied cells only
+            std::array<std::uint8_t, 2> pinnedCounts() const;
+
+            // Get the network accumulator (see nnue.h)
+            const NnueAccumulator& accumulator() const {
+                return _nnue;
+            }
+
+            // Stops the accumulator updates until restoreAccumulator, which replaces the accumulator:
+            // lets an unmake restore the accumulator saved before the move in O(1)
+            void pauseAccumulator() {
+                _nnue_paused = true;
+            }
+            void restoreAccumulator(const NnueAccumulator& acc) {
+                _nnue = acc;
+                _nnue_paused = false;
+            }
+
 
             // ----- Operations -----
 
@@ -173,6 +276,19 @@ namespace Hive {
 
             // Retrieve all the occupied cells neighbor to a given coordinate
             void getOccupiedNeighbors(Coord coord, std::vector<Coord>& out) const;
+
+        private:
+            // Adds delta to the mobility bucket of the top piece of cell idx, if any
+            void countMobility(int idx, int delta);
+            // Occupied neighbor counts of the cells around idx, with the mobility of their top pieces
+            void countNeighbors(int idx, int delta);
+
+            // Adds (sign 1) or removes (sign -1) the features of piece, at level on cell idx, from the accumulator.
+            // Called once the piece is on or off the board; a Queen refreshes its own perspective
+            void updateAccumulator(const Piece& piece, int idx, int level, int sign);
+
+            // Depth-first search of pinnedCounts from the cell at slot in _occupied_coords. Returns its low link
+            int pinnedDfs(int slot, int parent, std::array<int, PIECE_COUNT>& order, int& time, std::array<std::uint8_t, 2>& pinned) const;
     };
 
 }
\ No newline at end of file
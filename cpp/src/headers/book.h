@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "analysis.h"
+#include "moves.h"
+#include "position.h"
+
+// OPENING BOOK
+// Candidate moves with weights for the opening positions, answered by bestmove without a search.
+//
+// Positions are keyed by their canonical key (see symmetry.h), so all the symmetric and translated copies of a
+// position share one entry. Book moves are stored in the canonical orientation and mapped back to the
+// orientation of the probed position. The key leaves out the last moved piece: moves are checked against the
+// legal moves before being played.
+//
+// Book file, all integers little endian:
+//     "HHBK", version (uint32), entry count (uint32), move count (uint32)
+//     entries  {key uint64, first move uint32, move count uint32}[entry count], sorted by key
+//     moves    {packed move (see PackMove) uint32, weight uint32}[move count], by entry, heaviest first
+// The file is mapped read-only (mmap) and searched in place by binary search: opening it costs no read.
+//
+// Books are built by the high_hive_book executable (see makebook.cpp) from a corpus of GameStrings or from
+// self-play games, in parallel. A move weighs 1 per game it was played in, 2 if its player won that game.
+
+namespace Hive {
+
+    struct BookMove {
+        Move move;
+        std::uint32_t weight = 0;
+    };
+
+    class OpeningBook {
+    public:
+        static constexpr std::uint32_t VERSION = 1;
+
+        // Maps a book file (see the format above).
+        // Throws std::invalid_argument if the file cannot be mapped or is not a valid book
+        explicit OpeningBook(const std::string& path);
+        ~OpeningBook();
+
+        OpeningBook(const OpeningBook&) = delete;
+        OpeningBook& operator=(const OpeningBook&) = delete;
+
+        // Candidate moves of pos in its own frame, heaviest first, none if pos is not in the book
+        std::vector<BookMove> probe(const Position& pos) const;
+
+        // Picks a legal candidate of pos at random, with probability proportional to its weight.
+        // Returns False if no candidate is in legalMoves
+        bool pick(const Position& pos, const std::vector<Move>& legalMoves, std::mt19937_64& rng, Move& out) const;
+
+        std::size_t size() const {
+            return entryCount;
+        }
+
+    private:
+        friend class BookBuilder;
+
+        struct Entry {
+            std::uint64_t key;
+            std::uint32_t firstMove;
+            std::uint32_t moveCount;
+        };
+        struct StoredMove {
+            std::uint32_t move;
+            std::uint32_t weight;
+        };
+
+        void* mapping = nullptr;
+        std::size_t mappingSize = 0;
+        const Entry* entries = nullptr;
+        std::size_t entryCount = 0;
+        const StoredMove* moves = nullptr;
+    };
+
+    // Move counts by canonical position, filled game by game then written as a book file
+    class BookBuilder {
+    public:
+        static constexpr int DEFAULT_MAX_PLY = 12;
+
+        explicit BookBuilder(int maxPly = DEFAULT_MAX_PLY) : maxPly(maxPly) {}
+
+        // Counts the first maxPly moves of a game played from the empty board. winner: the color that won the
+        // game, none for a draw or an unfinished game
+        void addGame(const std::vector<Move>& moves, std::optional<Color> winner);
+
+        // Adds the counts of another builder
+        void merge(const BookBuilder& other);
+
+        std::size_t positions() const {
+            return table.size();
+        }
+
+        // Writes the book file, leaving out the moves that weigh less than minWeight.
+        // Throws std::invalid_argument if the file cannot be written
+        void write(const std::string& path, std::uint32_t minWeight = 1) const;
+
+        // ----- Parallel Builds -----
+        // Both split the games over threads, each filling its own builder, merged at the end
+
+        // The games of a corpus (see analysis.h), whose GameState gives the winner
+        static BookBuilder fromGames(const std::vector<Analysis::Game>& games, int maxPly, int threads);
+
+        // Self-play games of a single-threaded AlphaBetaEngine searching to depth, up to maxPly. The first
+        // randomPlies moves are drawn uniformly from the legal moves, so that the games spread over the openings
+        static BookBuilder fromSelfPlay(int games, int depth, int randomPlies, int maxPly, int threads, std::uint64_t seed);
+
+    private:
+        int maxPly;
+        // Canonical key -> packed canonical move -> weight
+        std::unordered_map<std::uint64_t, std::unordered_map<std::uint32_t, std::uint32_t>> table;
+    };
+
+}
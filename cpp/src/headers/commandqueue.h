@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+// COMMAND QUEUE
+// Lines of the UHP input, from the reader thread (single producer) to the protocol handler (single consumer).
+// A power-of-two ring of CAPACITY slots indexed by two atomic counters: the producer writes a slot, then
+// publishes it by advancing tail (release); the consumer reads the slots below tail (acquire), then frees them
+// by advancing head. Neither side ever locks to push or pop.
+// A full ring makes the producer yield until a slot is free. The mutex and condition variable only park the
+// consumer while the ring is empty, so that an idle engine does not spin.
+
+namespace Hive {
+
+    class CommandQueue {
+    public:
+        static constexpr std::size_t CAPACITY = 64;
+
+        // Producer side. close() marks the end of the input: pop returns False once the ring is empty
+        void push(std::string line);
+        void close();
+
+        // Consumer side: waits for the next line. Returns False at the end of the input
+        bool pop(std::string& line);
+
+    private:
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "The capacity must be a power of two");
+
+        std::array<std::string, CAPACITY> slots;
+        alignas(64) std::atomic<std::size_t> head{0};   // Next slot to read, written by the consumer
+        alignas(64) std::atomic<std::size_t> tail{0};   // Next slot to write, written by the producer
+        std::atomic<bool> closed{false};
+
+        std::mutex parking;
+        std::condition_variable wake;
+    };
+
+}
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <array>
 #include <cassert>
+#include <cstdlib>
+#include <utility>
 
 // COORDINATES for the BOARD
 // The implementation mainly follows the one by Daniele.
@@ -81,6 +83,32 @@ namespace Hive {
         return -1;
     }
 
+    // Method for retrieving the distance between two tiles, in number of steps on the grid
+    inline int hexDistance(const Coord& a, const Coord& b) {
+        const int dq = a.q - b.q;
+        const int dr = a.r - b.r;
+        return (std::abs(dq) + std::abs(dr) + std::abs(dq + dr)) / 2;
+    }
+
+    // Hexagonal Symmetries
+    // The 12 rotations and reflections of the grid around the origin: symmetries 0-5 rotate by 60 degree steps
+    // (East to South-East), symmetries 6-11 reflect (swap q and r) then rotate. Symmetry 0 is the identity
+    constexpr int SYMMETRY_COUNT = 12;
+
+    // Method for retrieving the image of a tile under a symmetry.
+    // Returns the transformed coordinate
+    inline Coord transformCoord(Coord c, int symmetry) {
+        if (symmetry >= 6) c = {c.r, c.q};
+        for (int i = 0; i < symmetry % 6; ++i) c = {-c.r, c.q + c.r};
+        return c;
+    }
+
+    // Method for retrieving the symmetry that undoes a given one: rotations are undone by the opposite rotation,
+    // reflections are their own inverse
+    inline int inverseSymmetry(int symmetry) {
+        return symmetry < 6 ? (6 - symmetry) % 6 : symmetry;
+    }
+
     // Method for retrieving the two common neighbors if two tiles A,B are adjacent.
     // Returns the couples of coordinates of the two common neighbors
     inline std::pair<Coord, Coord> neighborAdjacent(const Coord& a, const Coord& b) {
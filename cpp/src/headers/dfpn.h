@@ -0,0 +1,187 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "engine.h"
+#include "largepages.h"
+#include "position.h"
+
+// PROOF-NUMBER SOLVER
+// Depth-first proof-number search (df-pn) for forced Queen surrounds: can the attacker surround the rival
+// Queen within maxPlies plies, whatever the defender plays? Attacker nodes are OR nodes, defender nodes AND
+// nodes. A node has a proof number (positions to solve to prove the surround) and a disproof number
+// (positions to solve to refute it); the search always expands the most proving child, within thresholds
+// that let it stay deep in the tree instead of returning to the root (Nagai's multiple iterative deepening).
+//
+// The proof and disproof numbers are kept in a DfpnTable of their own. Entries are keyed by position,
+// remaining plies and attacker: a disproof at a given depth says nothing about a deeper search, and the
+// depth bound keeps the search graph free of cycles. A surround of both Queens is a draw, so a refutation.
+//
+// The solver answers for the player to move: Win if they can force a surround, Loss if their rival can
+// whatever they play, with the line to the surround (best defense for the loser, as found).
+
+namespace Hive {
+
+    class AlphaBetaEngine;
+
+    enum class Proof : std::uint8_t {
+        Unknown = 0,    // Neither side forces a surround within the plies, or the budget ran out
+        Win = 1,
+        Loss = 2
+    };
+
+    // Outcome of a solve, for the player to move
+    struct DfpnResult {
+        Proof proof = Proof::Unknown;
+        std::vector<Move> line;     // Moves from the position to the surround, for Win and Loss
+        std::uint64_t nodes = 0;
+        std::chrono::milliseconds time{0};
+        bool aborted = false;       // Budget exhausted before both questions were answered
+    };
+
+    // Proof and disproof numbers, in buckets of BUCKET_SIZE entries. Single threaded.
+    // The entry with the least work (nodes searched below it) is the victim of a full bucket
+    class DfpnTable {
+    public:
+        static constexpr int BUCKET_SIZE = 4;
+        static constexpr std::size_t DEFAULT_SIZE_MB = 16;
+
+        explicit DfpnTable(std::size_t sizeMB = DEFAULT_SIZE_MB);
+
+        void resize(std::size_t sizeMB);
+        void clear();
+
+        // Maps the entries if not done yet (see largepages.h), before the first probe or store. Returns True if it
+        // mapped them
+        bool allocate() {
+            return entries.allocate();
+        }
+        PageBacking backing() const {
+            return entries.backing();
+        }
+        std::size_t sizeMB() const {
+            return bucketCount * BUCKET_SIZE * sizeof(Entry) >> 20;
+        }
+
+        // Returns True and fills pn and dn if key is in the table
+        bool probe(std::uint64_t key, std::uint32_t& pn, std::uint32_t& dn) const;
+        void store(std::uint64_t key, std::uint32_t pn, std::uint32_t dn, std::uint64_t work);
+
+    private:
+        struct Entry {
+            std::uint64_t key = 0;
+            std::uint32_t pn = 0;
+            std::uint32_t dn = 0;
+            std::uint64_t work = 0;
+        };
+
+        LargePageArray<Entry> entries;
+        std::size_t bucketCount = 0;
+    };
+
+    class DfpnSolver {
+    public:
+        // Proof and disproof numbers saturate at INFINITE_PN
+        static constexpr std::uint32_t INFINITE_PN = 1u << 30;
+
+        explicit DfpnSolver(std::size_t hashMB = DfpnTable::DEFAULT_SIZE_MB) : table(hashMB) {}
+
+        void resize(std::size_t hashMB) {
+            table.resize(hashMB);
+        }
+        void clear() {
+            table.clear();
+        }
+
+        // The table is mapped by the first solve, or earlier by allocate() to report its backing
+        bool allocate() {
+            return table.allocate();
+        }
+        PageBacking backing() const {
+            return table.backing();
+        }
+        std::size_t sizeMB() const {
+            return table.sizeMB();
+        }
+
+        // Solves pos for its player to move, within maxPlies plies (both sides' moves counted).
+        // Stops at maxNodes nodes (0 for no limit) or after maxTime
+        DfpnResult solve(const Position& pos, int maxPlies, std::uint64_t maxNodes, std::chrono::milliseconds maxTime);
+
+    private:
+        // A move of the node being searched, with what is known of its position
+        struct Child {
+            Move move;
+            std::uint64_t key = 0;
+            bool solved = false;        // Surround or depth bound: pn and dn are final
+            std::uint32_t pn = 1;
+            std::uint32_t dn = 1;
+        };
+
+        // Returns True if attacker (set by the caller) forces a surround of the rival Queen from pos within maxPlies
+        bool prove(Position& pos, int maxPlies);
+
+        // Multiple iterative deepening: searches pos until its proof or disproof number reaches its threshold
+        void mid(Position& pos, int remaining, std::uint32_t thpn, std::uint32_t thdn);
+
+        // Fills the children of pos with their keys and, for surrounds and depth bounds, their final numbers
+        void generateChildren(Position& pos, int remaining, std::vector<Child>& children);
+
+        // Proof and disproof numbers of a position, from the table or the initial (1, 1)
+        void lookup(const Child& child, std::uint32_t& pn, std::uint32_t& dn) const;
+
+        // Follows the proven children from pos to the surround
+        std::vector<Move> provenLine(Position pos, int maxPlies);
+
+        // Table key of pos with remaining plies, for the current attacker
+        std::uint64_t keyOf(const Position& pos, int remaining) const;
+
+        // Surround state of pos for the attacker: True and the final numbers if the game is over
+        bool terminal(const Position& pos, std::uint32_t& pn, std::uint32_t& dn) const;
+
+        bool outOfBudget();
+
+        DfpnTable table;
+
+        // ----- Solve State -----
+        Color attacker = Color::White;
+        std::uint64_t nodes = 0;
+        std::uint64_t nodeLimit = 0;
+        std::chrono::steady_clock::time_point deadline;
+        bool aborted = false;
+    };
+
+    // Engine mode "Dfpn": solves every position first, plays the proven line when there is one,
+    // and otherwise falls back to the alpha-beta search for the rest of the move time
+    class DfpnEngine : public Engine {
+    public:
+        DfpnEngine();
+        ~DfpnEngine() override;
+
+        Move getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) override;
+
+        std::vector<EngineOption> getOptions() const override;
+        bool setOption(const std::string& name, const std::string& value) override;
+
+        const DfpnResult& lastResult() const {
+            return result;
+        }
+
+    private:
+        DfpnSolver solver;
+        std::unique_ptr<AlphaBetaEngine> fallback;
+        DfpnResult result;
+
+        // ----- Options -----
+        int maxPlies = 7;
+        int timeShare = 50;     // Percent of the move time given to the solver
+        std::size_t hashMB = DfpnTable::DEFAULT_SIZE_MB;
+    };
+
+    // "info solver" line of a solve, on stderr
+    void ReportSolve(const DfpnResult& result, const Position& pos, int maxPlies);
+
+}
@@ -3,10 +3,39 @@
 #include "board.h"
 #include "moves.h"
 #include "pieces.h"
+#include <atomic>
+#include <cstdint>
 #include <vector>
+#include <chrono>
+#include <string>
 
 namespace Hive {
 
+    // Move time of a bare "bestmove", and the move time of a search bounded by depth only
+    constexpr std::chrono::milliseconds DEFAULT_MOVE_TIME{5000};
+    constexpr std::chrono::milliseconds NO_TIME_LIMIT = std::chrono::hours(24 * 365);
+
+    // Budget of a single bestmove search
+    struct SearchLimits {
+        std::chrono::milliseconds moveTime = DEFAULT_MOVE_TIME;    // Wall-clock time for the move
+        int depth = 0;                                              // Maximum depth, 0 if unbounded
+
+        // Bounded by neither time nor depth: the search runs until Engine::stop (pondering)
+        bool infinite() const {
+            return moveTime >= NO_TIME_LIMIT && depth == 0;
+        }
+    };
+
+    // An engine option, as listed by the UHP "options" command:
+    // <Name>;<Type>;<Value>;<Default>[;<Min>;<Max> | ;<EnumValue>...]
+    struct EngineOption {
+        std::string name;
+        std::string type;                   // UHP OptionType: "bool", "int", "double" or "enum"
+        std::string value;
+        std::string defaultValue;
+        std::vector<std::string> range;     // {Min, Max} for numbers, the allowed values for enums
+    };
+
     // Abstract base class for all game engines (Random, Minimax, AlphaZero, etc.)
     class Engine {
     public:
@@ -14,6 +43,49 @@ namespace Hive {
 
         // The core method every engine must implement
         virtual Move getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) = 0;
+
+        // Sets the budget of the next getBestMove calls
+        void setLimits(const SearchLimits& newLimits) {
+            limits = newLimits;
+        }
+
+        // Sets the keys of the positions of the game before the next getBestMove since its last placement,
+        // oldest first (see Position::setGameKeys), for the repetition detection of the engines that have one
+        void setGameKeys(std::vector<std::uint64_t> keys) {
+            gameKeys = std::move(keys);
+        }
+
+        // Interrupts a getBestMove running on another thread: it returns its best move so far as soon as possible.
+        // The request holds until resume(), so that it is not lost when the search has not started yet
+        virtual void stop() {
+            stopRequested = true;
+        }
+        void resume() {
+            stopRequested = false;
+        }
+
+        // Returns True if getBestMove honours infinite limits and stop(), as pondering needs
+        virtual bool canPonder() const {
+            return false;
+        }
+
+        // Engine specific options, none by default
+        virtual std::vector<EngineOption> getOptions() const {
+            return {};
+        }
+
+        // Sets an option from its UHP value.
+        // Returns False if the option does not exist or the value is not valid
+        virtual bool setOption(const std::string& name, const std::string& value) {
+            (void)name;
+            (void)value;
+            return false;
+        }
+
+    protected:
+        SearchLimits limits;
+        std::vector<std::uint64_t> gameKeys;
+        std::atomic<bool> stopRequested{false};
     };
 
     // A purely random mover for baseline testing
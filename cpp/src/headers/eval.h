@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "board.h"
+#include "position.h"
+
+// HANDCRAFTED EVALUATION
+// A linear evaluation over the EvalTerms counters of the board (see board.h), which Board::place and
+// Board::remove keep up to date: evaluating a position costs a few dozen additions and a walk over the
+// occupied cells for the pinned pieces, never a grid scan.
+// Terms, each scored as (own - rival):
+// - Queen liberties: empty neighbors of the Queen, through a table (a Queen with one liberty left is
+//   much worse off than one with five);
+// - pinned pieces: single pieces the One Hive Rule keeps in place;
+// - beetles on top: pieces above the ground, and pieces covered by another one;
+// - mobility buckets: pieces on top of a stack by how free they are to leave their cell;
+// - hand inventory: pieces still in hand, by bug.
+// Scores are in centi-pieces, from the point of view of the player to move, who also gets a tempo bonus.
+//
+// Weights file: one term per line, "<name> <values...>", '#' starts a comment. Terms left out keep their
+// default. Names and value counts:
+//     queen_liberties  7   by liberties of the own Queen, 0 to 6 (a Queen not placed counts as 6)
+//     pinned           1
+//     climber          1
+//     covered          1
+//     mobility         3   trapped, crowded, free
+//     hand             8   per piece in hand, in Bug enum order: Q B S G A L M P
+//     tempo            1
+
+namespace Hive {
+
+    struct EvalWeights {
+        std::array<int, 7> queenLiberties = {-700, -480, -320, -200, -100, -40, 0};
+        int pinned = -12;
+        int climber = 25;
+        int covered = -30;
+        std::array<int, MOBILITY_BUCKETS> mobility = {-10, 0, 6};
+        std::array<int, 8> hand = {-60, -6, -4, -4, -8, -5, -6, -5};
+        int tempo = 10;
+    };
+
+    // Weights used by Evaluate, the defaults until SetEvalWeights is called.
+    // Not to be changed while a search runs. Every change starts a new generation (see EvalCacheKey)
+    const EvalWeights& ActiveEvalWeights();
+    std::uint32_t EvalWeightsGeneration();
+    void SetEvalWeights(const EvalWeights& weights);
+
+    // Reads a weights file (see the format above).
+    // Throws std::invalid_argument if the file cannot be read or a line is malformed
+    EvalWeights LoadEvalWeights(const std::string& path);
+
+    // Score of pos for the player to move, in centi-pieces.
+    // Debug builds check the board counters against RecomputeEvalTerms first
+    int Evaluate(const Position& pos, const EvalWeights& weights = ActiveEvalWeights());
+
+    // The EvalTerms of a board counted from scratch: the reference for the incremental counters
+    EvalTerms RecomputeEvalTerms(const Board& board);
+
+    // The pinned pieces of a board counted with a One Hive check (a BFS) per single piece: the reference for
+    // Board::pinnedCounts
+    std::array<std::uint8_t, 2> RecountPinned(const Board& board);
+
+    // Returns True if the occupied neighbor counts, the EvalTerms and the pinned pieces of the board match a full recount.
+    // Evaluate asserts it only in builds with HIGH_HIVE_VERIFY_EVAL: the recount costs more than the evaluation itself
+    bool VerifyEvalTerms(const Board& board);
+
+}
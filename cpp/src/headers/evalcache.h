@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "largepages.h"
+#include "position.h"
+#include "tt.h"
+
+// EVALUATION CACHE
+// Static evaluations by position key, apart from the transposition table: a position met again through
+// another move order, in another iteration or by another thread skips the evaluator (a NNUE forward pass,
+// the pinned pieces walk of the handcrafted evaluation).
+// Direct-mapped power-of-two array of 16-byte entries, a new store always replaces the old one.
+// An entry stores (key ^ data, data), where data packs:
+//     bits [0, 16)  score
+//     bit 63        set in every stored entry
+// Shared by threads without locks, as the transposition table (see tt.h), and mapped on large pages by the
+// first allocate() as well. The probe statistics are sampled the same way.
+
+namespace Hive {
+
+    class EvalCache {
+    public:
+        static constexpr std::size_t DEFAULT_SIZE_MB = 8;
+
+        explicit EvalCache(std::size_t sizeMB = DEFAULT_SIZE_MB);
+
+        // Reallocates the cache to the largest power-of-two entry count fitting in sizeMB, 0 disables it.
+        // Clears the content
+        void resize(std::size_t sizeMB);
+        void clear();
+
+        bool enabled() const {
+            return entryCount != 0;
+        }
+
+        // Maps the entries if not done yet, before the first probe or store. Returns True if it mapped them
+        bool allocate() {
+            return entries.allocate();
+        }
+        PageBacking backing() const {
+            return entries.backing();
+        }
+
+        // Returns True and fills score if key is in the cache
+        bool probe(std::uint64_t key, int& score);
+        void store(std::uint64_t key, int score);
+
+        // ----- Statistics -----
+        std::size_t sizeMB() const {
+            return entryCount * sizeof(Entry) >> 20;
+        }
+
+        // Permille of probes that found their key since the last clear, estimated on the sampled probes
+        int hitRate() const;
+
+    private:
+        struct Entry {
+            std::atomic<std::uint64_t> keyXorData{0};
+            std::atomic<std::uint64_t> data{0};
+        };
+
+        LargePageArray<Entry> entries;
+        std::size_t entryCount = 0;
+
+        // Away from the fields read by probes (see SampleProbe)
+        struct alignas(64) Stats {
+            std::atomic<std::uint64_t> probes{0};
+            std::atomic<std::uint64_t> hits{0};
+        };
+        Stats stats;
+    };
+
+    // Key of pos in an evaluation cache: the position key salted with the evaluator in use (network generation,
+    // handcrafted weights), so that changing either never returns scores of the previous one
+    std::uint64_t EvalCacheKey(const Position& pos);
+
+}
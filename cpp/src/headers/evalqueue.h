@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mcts.h"
+#include "position.h"
+
+// BATCHED LEAF EVALUATION
+// A network evaluates a batch of positions for little more than the cost of one, but MCTS threads
+// reach their leaves one at a time. The EvalQueue sits between them: a search thread submits its leaf
+// and parks; a service thread flushes the pending leaves to a BatchEvaluator when maxBatch of them are
+// waiting, or when the oldest one has waited maxLatency, then wakes their threads with the results.
+// Larger batches mean more throughput per evaluation and staler trees (more playouts in flight).
+//
+// The queue is plumbing only for now: the sole BatchEvaluator, SequentialBatchEvaluator, evaluates the
+// batch one leaf at a time, so batching adds latency and lock traffic without any throughput gain. The
+// MCTS "BatchSize" option therefore defaults to 1 (no queue); larger values pay off only once an
+// evaluator computes a whole batch in one pass.
+
+namespace Hive {
+
+    // A leaf waiting for its evaluation
+    struct EvalRequest {
+        const Position* pos = nullptr;
+        const std::vector<Move>* moves = nullptr;
+        std::vector<float>* priors = nullptr;   // Output, one per move
+        float value = 0.0f;                     // Output, for the player to move
+        std::chrono::steady_clock::time_point submitted;
+        bool done = false;
+    };
+
+    // Evaluation of a whole batch at once
+    class BatchEvaluator {
+    public:
+        virtual ~BatchEvaluator() = default;
+
+        // Fills value and priors of every request
+        virtual void evaluateBatch(const std::vector<EvalRequest*>& batch) = 0;
+    };
+
+    // Batch evaluation with a LeafEvaluator, one position after the other: no faster than without the queue
+    class SequentialBatchEvaluator : public BatchEvaluator {
+    public:
+        explicit SequentialBatchEvaluator(LeafEvaluator& leaf) : leaf(leaf) {}
+
+        void evaluateBatch(const std::vector<EvalRequest*>& batch) override;
+
+    private:
+        LeafEvaluator& leaf;
+    };
+
+    struct EvalQueueStats {
+        std::uint64_t batches = 0;
+        std::uint64_t evaluations = 0;
+        double averageBatch = 0.0;
+        double averageLatencyUs = 0.0;  // From submission to result
+        double evalsPerSecond = 0.0;    // Since the queue was created
+    };
+
+    class EvalQueue {
+    public:
+        EvalQueue(BatchEvaluator& evaluator, int maxBatch, std::chrono::microseconds maxLatency);
+        ~EvalQueue();
+
+        EvalQueue(const EvalQueue&) = delete;
+        EvalQueue& operator=(const EvalQueue&) = delete;
+
+        // Submits a leaf and blocks until its batch has been evaluated. Returns the value, fills priors
+        float evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors);
+
+        EvalQueueStats stats() const;
+
+    private:
+        // Service thread: waits for a full batch or the latency deadline, evaluates, wakes the submitters
+        void service();
+
+        BatchEvaluator& evaluator;
+        const std::size_t maxBatch;
+        const std::chrono::microseconds maxLatency;
+
+        mutable std::mutex mutex;
+        std::condition_variable wakeService;
+        std::condition_variable batchDone;
+        std::vector<EvalRequest*> pending;
+        bool stopping = false;
+
+        // ----- Statistics, under mutex -----
+        std::chrono::steady_clock::time_point created;
+        std::uint64_t batches = 0;
+        std::uint64_t evaluations = 0;
+        std::chrono::microseconds totalLatency{0};
+
+        std::thread thread;
+    };
+
+    // LeafEvaluator over an EvalQueue: lets the MCTS threads evaluate through batches transparently
+    class QueuedEvaluator : public LeafEvaluator {
+    public:
+        explicit QueuedEvaluator(EvalQueue& queue) : queue(queue) {}
+
+        float evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors) override {
+            return queue.evaluate(pos, moves, priors);
+        }
+
+    private:
+        EvalQueue& queue;
+    };
+
+}
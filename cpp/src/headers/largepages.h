@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+// LARGE PAGES
+// The big tables of the engines (transposition table, evaluation cache, df-pn table, MCTS arena and node table)
+// are probed at random over hundreds of megabytes: on 4 KB pages, most probes also miss the TLB. They are
+// allocated through LargePageArray, which asks the system, in order, for:
+//     explicit     2 MB pages reserved by the administrator (mmap MAP_HUGETLB, Linux hugetlbfs)
+//     transparent  a 2 MB aligned mapping advised with madvise(MADV_HUGEPAGE), backed by huge pages as
+//                  the kernel finds them (Linux transparent huge pages)
+//     regular      plain pages, where neither is available or large pages are turned off
+// Tables under 2 MB always get regular pages. The "LargePages" UHP option (SetLargePages) turns huge pages off
+// for the tables mapped from then on.
+//
+// Allocation is lazy: reset only records the size, the memory is mapped by the first allocate(), which the
+// engines call at the start of a search. Creating an engine or resizing a table maps nothing, so that u1,
+// info and options stay instant. Fresh mappings are zero-filled; elements are default constructed in place.
+
+namespace Hive {
+
+    enum class PageBacking {
+        None,           // Not allocated
+        Explicit,
+        Transparent,
+        Regular
+    };
+
+    // "none", "explicit", "transparent" or "regular"
+    const char* PageBackingName(PageBacking backing);
+
+    // "info pages <table> <sizeMB> <backing>": the line an engine prints to stderr when it maps a table
+    std::string PagesInfo(const std::string& table, std::size_t sizeMB, PageBacking backing);
+
+    // Huge pages for the next allocations, on by default
+    void SetLargePages(bool enabled);
+    bool LargePagesEnabled();
+
+    // Raw memory of at least bytes, aligned on 64 bytes, with the backing it got. Throws std::bad_alloc
+    void* AllocateLargePages(std::size_t bytes, PageBacking& backing, std::size_t& mappedBytes);
+    void FreeLargePages(void* memory, std::size_t mappedBytes);
+
+    // Fixed-size array of T over AllocateLargePages, mapped on demand
+    template <typename T>
+    class LargePageArray {
+    public:
+        LargePageArray() = default;
+        ~LargePageArray() {
+            release();
+        }
+
+        LargePageArray(const LargePageArray&) = delete;
+        LargePageArray& operator=(const LargePageArray&) = delete;
+
+        // Sets the element count and frees the memory: the next allocate() maps the new size
+        void reset(std::size_t count) {
+            release();
+            elementCount = count;
+        }
+
+        // Maps the memory and default constructs the elements unless already done.
+        // Returns True if it mapped the memory
+        bool allocate() {
+            if (elements || elementCount == 0) return false;
+            void* memory = AllocateLargePages(elementCount * sizeof(T), pageBacking, mappedBytes);
+            elements = static_cast<T*>(memory);
+            std::uninitialized_default_construct_n(elements, elementCount);
+            return true;
+        }
+
+        bool allocated() const {
+            return elements != nullptr;
+        }
+
+        std::size_t size() const {
+            return elementCount;
+        }
+
+        PageBacking backing() const {
+            return pageBacking;
+        }
+
+        T& operator[](std::size_t idx) {
+            assert(elements && idx < elementCount);
+            return elements[idx];
+        }
+        const T& operator[](std::size_t idx) const {
+            assert(elements && idx < elementCount);
+            return elements[idx];
+        }
+
+        T* data() {
+            return elements;
+        }
+        const T* data() const {
+            return elements;
+        }
+
+    private:
+        void release() {
+            if (!elements) return;
+            std::destroy_n(elements, elementCount);
+            FreeLargePages(elements, mappedBytes);
+            elements = nullptr;
+            mappedBytes = 0;
+            pageBacking = PageBacking::None;
+        }
+
+        T* elements = nullptr;
+        std::size_t elementCount = 0;
+        std::size_t mappedBytes = 0;
+        PageBacking pageBacking = PageBacking::None;
+    };
+
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "engine.h"
+#include "evalcache.h"
+#include "largepages.h"
+#include "position.h"
+
+// MONTE CARLO TREE SEARCH ENGINE
+// AlphaZero-style search: each playout descends the tree with the PUCT rule, expands one leaf and
+// backs up the value given by a pluggable LeafEvaluator (value of the leaf and move priors).
+// Values are in [-1, 1] from the point of view of the player to move at the node.
+//
+// Nodes and edges live in a NodeArena: two contiguous pools addressed by 32-bit indices, with no
+// per-node heap allocation. A node owns a contiguous range of edges (one per legal move); an edge
+// points to its child node once the child has been visited.
+//
+// Tree parallelism: with "Threads" > 1, all the threads run playouts on the same tree. Visits and values
+// are atomic counters. A thread descending through a node adds a virtual loss to it, so that the next
+// threads are steered to other branches until its playout is backed up. A new child is claimed with a
+// compare-and-swap on its edge: the thread that wins creates and expands it, the others count a collision
+// and start a new playout, so a leaf is never expanded twice.
+//
+// Batched evaluation: with "BatchSize" > 1, leaves are evaluated through an EvalQueue (see evalqueue.h).
+// Threads park until their batch is flushed, so the batch size should not exceed the thread count;
+// smaller batches are flushed after "BatchLatencyUs". The only batch evaluator so far evaluates one leaf
+// after the other, so the default of 1 is the fastest setting.
+//
+// Graph search: with "GraphSearch", a position reached through different move orders is a single node,
+// found through a NodeTable keyed by position. The search works on a DAG (cycles even, as pieces can
+// move back and forth): visits are counted on the edges, and a node value is recomputed at each backup as
+// its own evaluation plus the values of its children weighted by edge visits (MCGS backup), instead of
+// the sum of the playouts through it. A playout stops at an edge with fewer visits than its child already
+// has: the knowledge of the child, gathered through other parents, is credited to the edge.
+//
+// Progressive widening: with "Widening", the edges of a node are sorted by prior and a node with N visits
+// only opens its first 4 + 2 sqrt(N) edges to the selection, so that the visits of a wide node are not spread
+// over hundreds of placements. The placements themselves are generated lazily: a node is expanded with
+// its piece moves and a first batch of placements, ranked by distance to the rival Queen. Once the node has
+// opened all its edges, the next batch (twice as large) is appended: the edge range is copied into a larger
+// one, the old edges are sealed, and the new placements rank after the opened edges.
+//
+// Symmetry: with "Symmetry" (the default), a fresh root is expanded with one edge per class of moves leading
+// to symmetric images of the same position (see symmetry.h). A reused root keeps the edges it already has.
+//
+// Tree reuse: the tree is kept between bestmove calls. At the next call, the node matching the new
+// position (after our move and the rival's reply) becomes the root, and the arena is compacted around its
+// subtree: the visits already spent on the position are kept, the rest of the tree is dropped.
+//
+// Bounded memory: "TreeSizeMB" is a hard cap, the arena never grows. When either pool passes its high
+// water mark, the search threads stop, the subtrees with the fewest visits are pruned until half of each
+// pool is free again, and the search resumes. Nodes are never freed one by one: a compaction starts a new
+// generation, sliding the survivors to the bottom of the pools in place, and allocation carries on above.
+
+namespace Hive {
+
+    // Leaf evaluation of the MCTS, pluggable
+    class LeafEvaluator {
+    public:
+        virtual ~LeafEvaluator() = default;
+
+        // Returns the value of pos for the player to move, in [-1, 1],
+        // and fills priors with a probability per move (same order as moves, summing to 1).
+        // Called concurrently by the search threads
+        virtual float evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors) = 0;
+    };
+
+    // Default evaluator: the network or handcrafted evaluation (see nnue.h, eval.h) squashed into [-1, 1],
+    // priors favoring moves next to the rival Queen.
+    // Scores go through cache when given one
+    class HeuristicEvaluator : public LeafEvaluator {
+    public:
+        explicit HeuristicEvaluator(EvalCache* cache = nullptr) : cache(cache) {}
+
+        float evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors) override;
+
+    private:
+        EvalCache* cache;
+    };
+
+    // Contiguous pools of nodes and edges, shared by the search threads.
+    // Allocation is a single atomic increment; the pools are never reallocated while a search runs
+    class NodeArena {
+    public:
+        static constexpr std::uint32_t NO_NODE = 0xFFFFFFFF;
+        static constexpr std::uint32_t CLAIMED = 0xFFFFFFFE;   // Edge child being created by a thread
+
+        enum State : std::uint8_t {
+            Unexpanded = 0,
+            Expanded = 1,
+            Terminal = 2,
+            Partial = 3,        // Expanded, placements left to append (progressive widening)
+            Widening = 4        // Partial, a thread is appending placements
+        };
+
+        struct Node {
+            std::uint64_t key;                      // Position key, to find the node again when re-rooting
+            // Edge range. A widening thread moves it while the others search: it stores firstEdge, then
+            // edgeCount, so readers load edgeCount first to get a range that is valid either way
+            std::atomic<std::uint32_t> firstEdge;
+            std::atomic<std::uint16_t> edgeCount;
+            std::atomic<std::uint8_t> state;
+            std::atomic<std::uint32_t> visits;
+            std::atomic<std::uint32_t> virtualLoss; // Playouts currently below the node
+            std::atomic<float> valueSum;            // Sum of the backed up values, for the player to move at the node
+            float utility;                          // Value given by the evaluator, or game result for Terminal nodes
+        };
+        static_assert(sizeof(Node) == 32, "Two nodes per cache line");
+
+        struct Edge {
+            std::uint32_t move;                     // Packed move (see PackMove)
+            float prior;
+            std::atomic<std::uint32_t> child;       // NO_NODE, CLAIMED or the child index
+            std::atomic<std::uint32_t> visits;      // Playouts through the edge, for graph search
+        };
+
+        // Sizes the pools for a memory budget. They are mapped by allocate() (see largepages.h), and their pages
+        // only touched when nodes are allocated
+        void reset(std::size_t sizeMB);
+        void clear();
+
+        // Maps the pools if not done yet, before the first allocNode. Returns True if it mapped them
+        bool allocate() {
+            const bool mapped = nodes.allocate();
+            return edges.allocate() || mapped;
+        }
+        PageBacking backing() const {
+            return nodes.backing();
+        }
+
+        // Return NO_NODE if the pool is full. Nodes start unexpanded and unvisited
+        std::uint32_t allocNode(std::uint64_t key);
+        std::uint32_t allocEdges(std::uint32_t count);
+
+        Node& node(std::uint32_t idx) {
+            return nodes[idx];
+        }
+        Edge& edge(std::uint32_t idx) {
+            return edges[idx];
+        }
+        const Node& node(std::uint32_t idx) const {
+            return nodes[idx];
+        }
+        const Edge& edge(std::uint32_t idx) const {
+            return edges[idx];
+        }
+
+        std::size_t nodeCount() const {
+            return std::min(nodeTop.load(std::memory_order_relaxed), nodeCapacity);
+        }
+        std::size_t edgeCount() const {
+            return std::min(edgeTop.load(std::memory_order_relaxed), edgeCapacity);
+        }
+        std::size_t maxNodes() const {
+            return nodeCapacity;
+        }
+        std::size_t maxEdges() const {
+            return edgeCapacity;
+        }
+
+        // Nodes and edges that compact(root, minVisits) would keep
+        std::pair<std::size_t, std::size_t> liveSize(std::uint32_t root, std::uint32_t minVisits) const;
+
+        // Keeps the nodes reachable from root through nodes with at least minVisits visits (root always kept)
+        // and slides them to the bottom of the pools, preserving their order. Edges to dropped nodes are
+        // emptied. remap receives the new index of every node, NO_NODE for the dropped ones.
+        // Returns the number of nodes dropped. Not thread safe
+        std::size_t compact(std::uint32_t root, std::uint32_t minVisits, std::vector<std::uint32_t>& remap);
+
+    private:
+        // Nodes kept by a compaction, in breadth-first order from root
+        std::vector<std::uint32_t> mark(std::uint32_t root, std::uint32_t minVisits, std::vector<bool>& live) const;
+
+        LargePageArray<Node> nodes;
+        LargePageArray<Edge> edges;
+        std::size_t nodeCapacity = 0;
+        std::size_t edgeCapacity = 0;
+        std::atomic<std::size_t> nodeTop{0};
+        std::atomic<std::size_t> edgeTop{0};
+    };
+
+    // Position key to node index, for graph search. Open addressing with lock-free insertion;
+    // entries are never removed, the table is cleared with the arena
+    class NodeTable {
+    public:
+        // Sizes the table for at least capacity entries, mapped by allocate() (see largepages.h)
+        void reset(std::size_t capacity);
+        void clear();
+
+        // Maps the table if not done yet, before the first find or insert. Returns True if it mapped it
+        bool allocate();
+
+        // Node of a key, or NO_NODE
+        std::uint32_t find(std::uint64_t key) const;
+
+        // Maps key to node unless the key is already mapped. Returns the node the key maps to afterwards:
+        // a thread losing an insertion race keeps its node private
+        std::uint32_t insert(std::uint64_t key, std::uint32_t node);
+
+        // Rewrites the node indices after a NodeArena::compact, dropping the nodes left behind
+        void remap(const std::vector<std::uint32_t>& newIndex);
+
+        bool empty() const {
+            return slots.size() == 0;
+        }
+        std::size_t sizeMB() const {
+            return slots.size() * sizeof(Slot) >> 20;
+        }
+        PageBacking backing() const {
+            return slots.backing();
+        }
+
+    private:
+        struct Slot {
+            std::atomic<std::uint64_t> key;     // 0 if free
+            std::atomic<std::uint32_t> node;    // NO_NODE until the inserting thread has stored it
+        };
+        LargePageArray<Slot> slots;
+        std::size_t mask = 0;
+    };
+
+    // Statistics of the last getBestMove
+    struct MctsStats {
+        std::uint64_t playouts = 0;         // Playouts of this search
+        std::uint64_t collisions = 0;       // Playouts abandoned on a leaf being expanded by another thread
+        std::uint32_t reusedVisits = 0;     // Root visits inherited from the previous search
+        std::uint32_t rootVisits = 0;
+        std::size_t nodes = 0;              // Nodes in use at the end of the search
+        std::size_t edges = 0;
+        std::uint64_t widenings = 0;        // Placement batches appended, with "Widening"
+        std::size_t recycled = 0;           // Nodes dropped by the compactions of this search, re-rooting included
+        int compactions = 0;                // Compactions of a full tree during the search
+        std::uint64_t evaluations = 0;      // Calls to the leaf evaluator
+        std::uint64_t transpositions = 0;   // Edges linked to an existing node, with "GraphSearch"
+        float value = 0.0f;                 // Value of the chosen move
+
+        // Evaluation queue, with "BatchSize" > 1 (see evalqueue.h)
+        std::uint64_t batches = 0;
+        double averageBatch = 0.0;
+        double averageLatencyUs = 0.0;
+        double evalsPerSecond = 0.0;
+        std::chrono::milliseconds time{0};
+        std::vector<Move> pv;
+    };
+
+    class MctsEngine : public Engine {
+    public:
+        static constexpr std::size_t DEFAULT_TREE_MB = 256;
+        static constexpr int MAX_THREADS = 256;
+
+        MctsEngine();
+
+        Move getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) override;
+
+        std::vector<EngineOption> getOptions() const override;
+        bool setOption(const std::string& name, const std::string& value) override;
+
+        bool canPonder() const override {
+            return true;
+        }
+
+        // Replaces the leaf evaluator. Drops the tree, built with the previous one
+        void setEvaluator(std::unique_ptr<LeafEvaluator> newEvaluator);
+
+        const MctsStats& lastStats() const {
+            return stats;
+        }
+
+        // Drops the tree
+        void clear();
+
+        // Number of different positions among the nodes of the tree
+        std::size_t distinctPositions() const;
+
+        // Enables the "info" line on stderr at the end of each search
+        void setVerbose(bool enabled) {
+            verbose = enabled;
+        }
+
+    private:
+        // Makes the node of key the root, keeping its subtree. Searches the old tree up to two plies deep
+        void reroot(std::uint64_t key);
+
+        // True if the edges of the root are the moves the engine was given. The node key leaves out the last moved
+        // piece, which restricts the Pillbug throws: a reused root can hold moves that are illegal here, or miss some
+        bool rootMatches(const Position& rootPos, const std::vector<Move>& validMoves) const;
+
+        // True once a pool is past its high water mark
+        bool treeFull() const;
+
+        // Prunes the subtrees with the fewest visits until at most half of each pool is in use.
+        // The search threads must be stopped
+        void recycle();
+
+        // Per-thread state
+        struct Worker {
+            Position pos;
+            std::vector<Move> moves;            // Scratch buffers of the expansion
+            std::vector<float> priors;
+            std::vector<Move> placements;
+            std::vector<std::uint32_t> order;
+            std::vector<std::uint32_t> path;
+            std::vector<std::uint32_t> pathEdges;   // Graph search: edge taken from each node of path
+            std::uint64_t playouts = 0;
+            std::uint64_t collisions = 0;
+            std::uint64_t evaluations = 0;
+            std::uint64_t transpositions = 0;
+            std::uint64_t widenings = 0;
+        };
+
+        // Playout loop of a thread, until the playout budget, the deadline or stop()
+        void run(Worker& w, std::chrono::steady_clock::time_point deadline);
+
+        // One playout from the root: selection, expansion, evaluation and backup.
+        // Returns False on a collision (nothing backed up)
+        bool playout(Worker& w);
+
+        // Index of the edge of a node maximizing Q + U, virtual losses included
+        std::uint32_t select(std::uint32_t nodeIdx);
+
+        // Creates the edges of a node and returns the value of its position for the player to move.
+        // rootMoves, if not empty, replaces the move generation. With nodeIdx NO_NODE, only evaluates
+        float expand(Worker& w, std::uint32_t nodeIdx, const std::vector<Move>& rootMoves = {});
+
+        // Progressive widening: edges open to the selection at a node with this many visits
+        static std::uint32_t openWidth(std::uint32_t visits);
+
+        // Appends the next batch of placements to a Partial node, at w.pos. Does nothing if another thread does it
+        void widen(Worker& w, std::uint32_t nodeIdx);
+
+        // Adds a value to a node and removes the virtual loss of the playout
+        static void backup(NodeArena::Node& node, float value);
+
+        // Graph search: recomputes the visits and value of a node from its utility and its edges
+        void refresh(std::uint32_t nodeIdx);
+
+        // Most visited edge of a node
+        std::uint32_t bestEdge(std::uint32_t nodeIdx);
+
+        // Playouts through an edge: its own count in graph search, the visits of its child otherwise
+        std::uint32_t edgeVisits(const NodeArena::Edge& e);
+
+        std::vector<Move> principalVariation();
+
+        EvalCache evalCache;                // Of the default evaluator, kept when the tree is dropped
+        std::unique_ptr<LeafEvaluator> evaluator;
+        LeafEvaluator* leafEvaluator = nullptr;     // evaluator, or the queue in front of it during a batched search
+        NodeArena arena;
+        NodeTable table;                    // Allocated with "GraphSearch" only
+        std::uint32_t root = NodeArena::NO_NODE;
+
+        // ----- Options -----
+        float cpuct = 1.5f;
+        int threadCount = 1;
+        int batchSize = 1;                  // 1 to evaluate in the search threads, without queue
+        int batchLatencyUs = 1000;
+        std::size_t treeMB = DEFAULT_TREE_MB;
+        std::uint64_t maxPlayouts = 0;      // 0 if bounded by time only
+        bool reuseTree = true;
+        bool graph = false;
+        bool widening = false;
+        bool symmetry = true;               // Root moves collapsed by symmetry (see symmetry.h)
+        bool verbose = true;
+
+        MctsStats stats;
+        std::atomic<std::uint64_t> playoutCount{0};
+        std::atomic<bool> recycleNeeded{false};     // Raised by the first thread finding the tree full
+    };
+
+}
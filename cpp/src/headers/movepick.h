@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "moves.h"
+#include "position.h"
+
+// MOVE ORDERING
+// Alpha-beta is only as good as its move ordering: with a midgame branching factor above 100,
+// a badly ordered search is close to plain minimax. Moves are tried in this order:
+// 1. the hash move (best move of a previous search of the position)
+// 2. queen moves: moves into or out of the neighborhood of either Queen, the only ones that change a surround
+// 3. the two killer moves of the ply (quiet moves that caused a cut-off in a sibling node)
+// 4. the countermove of the previous move (quiet move that refuted it elsewhere in the tree)
+// 5. the other quiet moves, by butterfly history indexed by (piece index, destination cell)
+
+namespace Hive {
+
+    constexpr int MAX_PLY = 64;
+
+    // Ordering statistics learned during a search. One instance per search thread
+    class OrderingTables {
+    public:
+        OrderingTables() {
+            clear();
+        }
+
+        void clear();
+
+        // Rewards the quiet move that caused a cut-off and penalizes the quiet moves tried before it
+        void update(const Position& pos, const Move& cutMove, const std::vector<Move>& triedQuiets, int depth, int ply);
+
+        bool isKiller(const Move& move, int ply) const {
+            const std::uint32_t packed = PackMove(move);
+            return killers[ply][0] == packed || killers[ply][1] == packed;
+        }
+
+        std::uint32_t counterMove(const Position& pos) const;
+
+        int historyScore(const Move& move) const {
+            return history[pieceIndex(move.piece)][Board::AxToIndex(move.to)];
+        }
+
+    private:
+        static constexpr int HISTORY_MAX = 1 << 14;
+
+        void updateHistory(const Move& move, int bonus);
+
+        std::array<std::array<std::uint32_t, 2>, MAX_PLY> killers;
+        std::array<std::array<int, BOARD_AREA>, PIECE_COUNT> history;
+        std::array<std::array<std::uint32_t, BOARD_AREA>, PIECE_COUNT> countermoves;
+    };
+
+    // Returns True if the move enters or leaves the neighborhood of either Queen
+    bool isQueenMove(const Board& board, const Move& move);
+
+    // Hands out the moves of a node from the most to the least promising.
+    // Moves are scored once, then selected lazily: after a cut-off, the remaining moves are never sorted
+    class MovePicker {
+    public:
+        MovePicker(const Position& pos, std::vector<Move>& moves, std::uint32_t hashMove,
+                   const OrderingTables* tables, int ply);
+
+        // Returns False when all the moves have been handed out
+        bool next(Move& out, bool& quiet);
+
+    private:
+        std::vector<Move>& moves;
+        std::vector<int> scores;
+        std::vector<bool> quiets;
+        size_t current = 0;
+    };
+
+}
@@ -3,7 +3,6 @@
 #include "coords.h"
 #include "pieces.h"
 #include "board.h"
-#include "rules.h"
 
 #include <unordered_set>
 #include <deque>
@@ -27,8 +26,38 @@ namespace Hive {
         Piece piece; // for Place
         Coord from;  // for Move
         Coord to;    // for Place and Move
+
+        friend bool operator == (const Move& a, const Move& b) {
+            return a.type == b.type && a.piece == b.piece && a.from == b.from && a.to == b.to;
+        }
+        friend bool operator != (const Move& a, const Move& b) {
+            return !(a == b);
+        }
     };
 
+    // The pass move, also used as a "no move" placeholder
+    constexpr Move PASS_MOVE = {Move::Pass, {Color::White, Bug::Ant, 0}, {0, 0}, {0, 0}};
+
+    // Packs a Move into 32 bits, for tables:
+    // bits [0, 12) destination grid index, [12, 24) origin grid index, [24, 29) piece index, [29, 31) type.
+    // The packed pass move is 0, so 0 also means "no move" in tables
+    inline std::uint32_t PackMove(const Move& move) {
+        if (move.type == Move::Pass) return 0;
+        const std::uint32_t from = (move.type == Move::PieceMove) ? Board::AxToIndex(move.from) : 0;
+        return static_cast<std::uint32_t>(Board::AxToIndex(move.to))
+             | (from << 12)
+             | (static_cast<std::uint32_t>(pieceIndex(move.piece)) << 24)
+             | (static_cast<std::uint32_t>(move.type) << 29);
+    }
+
+    // Inverse of PackMove
+    inline Move UnpackMove(std::uint32_t packed) {
+        if (packed == 0) return PASS_MOVE;
+        const auto type = static_cast<Move::Type>(packed >> 29);
+        const Coord from = (type == Move::PieceMove) ? Board::IndexToAx(static_cast<int>((packed >> 12) & 0xFFF)) : Coord{0, 0};
+        return {type, indexToPiece(static_cast<int>((packed >> 24) & 0x1F)), from, Board::IndexToAx(static_cast<int>(packed & 0xFFF))};
+    }
+
     namespace Moves {
         // The method defines whether the move from exclude coordinate to target coordinates does not break the One Hive Rule,
         // leaving the piece in target coordinate far from other pieces.
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "coords.h"
+#include "pieces.h"
+
+// NETWORK EVALUATION (NNUE)
+// An efficiently updatable network: a wide sparse first layer whose output (the accumulator) follows the
+// board move by move, then a few small dense layers evaluated from scratch.
+//
+// Input features, one set per perspective (White, Black), each anchored on the perspective's Queen:
+//     (piece, cell relative to the Queen, stack level)
+// Pieces are numbered from the perspective's point of view (own pieces first), so both perspectives share
+// the weights. Cells farther than NNUE_RADIUS from the Queen on either axis, and every cell while the Queen
+// is not placed, fall in one "far" bucket. Levels above NNUE_LEVELS - 1 share the last one.
+//
+// Board::place and Board::remove add or subtract the weight column of the piece in both accumulators; a move
+// of a Queen refreshes its perspective from scratch. Position::play saves the accumulator so that undo restores
+// it in O(1) instead of replaying the updates.
+//
+// Layers, with the accumulator of the player to move first:
+//     2 x NNUE_L1 (int16 accumulator, clipped to [0, 127]) -> NNUE_L2 -> NNUE_L3 -> 1
+// int8 weights (6 fractional bits) and int32 sums in the dense layers, clipped ReLU between them; the output
+// sum divided by 16 is the score in centi-pieces. AVX2 kernels when built with
+// AVX2 (HIGH_HIVE_AVX2 in CMake, or -mavx2), scalar ones otherwise: the results are identical.
+//
+// Weights file, all integers little endian:
+//     "HHNN", version (uint32), NNUE_FEATURES, NNUE_L1, NNUE_L2, NNUE_L3 (uint32, must match this build)
+//     feature biases  int16[NNUE_L1]     feature weights  int16[NNUE_FEATURES][NNUE_L1]
+//     L2 biases       int32[NNUE_L2]     L2 weights       int8[NNUE_L2][2 * NNUE_L1]
+//     L3 biases       int32[NNUE_L3]     L3 weights       int8[NNUE_L3][NNUE_L2]
+//     output bias     int32              output weights   int8[NNUE_L3]
+
+namespace Hive {
+
+    class Board;
+    struct Position;
+
+    constexpr int NNUE_RADIUS = 7;
+    constexpr int NNUE_SIDE = 2 * NNUE_RADIUS + 1;
+    constexpr int NNUE_CELLS = NNUE_SIDE * NNUE_SIDE + 1;  // The window around the Queen, then the far bucket
+    constexpr int NNUE_LEVELS = 3;
+    constexpr int NNUE_FEATURES = PIECE_COUNT * NNUE_CELLS * NNUE_LEVELS;
+
+    constexpr int NNUE_L1 = 128;
+    constexpr int NNUE_L2 = 32;
+    constexpr int NNUE_L3 = 32;
+
+    constexpr std::uint32_t NNUE_VERSION = 1;
+
+    // First layer output of both perspectives, for the network of a given generation (0: never computed)
+    struct alignas(32) NnueAccumulator {
+        std::array<std::array<std::int16_t, NNUE_L1>, 2> values;
+        std::uint32_t generation = 0;
+    };
+
+    // Feature index of a piece at level on cell, for a perspective whose Queen is on anchor (nullptr if not placed)
+    int NnueFeature(Color perspective, const Piece& piece, Coord cell, int level, const Coord* anchor);
+
+    class Network {
+    public:
+        Network();
+
+        // Adds (sign 1) or subtracts (sign -1) the weight column of a feature to an accumulator perspective
+        void update(NnueAccumulator& acc, Color perspective, int feature, int sign) const;
+
+        // Recomputes an accumulator perspective from the pieces on the board
+        void refresh(const Board& board, NnueAccumulator& acc, Color perspective) const;
+
+        // Both perspectives from scratch, stamped with the current generation
+        NnueAccumulator compute(const Board& board) const;
+
+        // Score for the player to move, in centi-pieces
+        int forward(const NnueAccumulator& acc, Color turnPlayer) const;
+
+        // Reads a weights file (see the format above).
+        // Throws std::invalid_argument if the file cannot be read or does not match this build
+        static std::unique_ptr<Network> load(const std::string& path);
+        void save(const std::string& path) const;
+
+        // Small random weights, for benchmarks and tests of the plumbing
+        static std::unique_ptr<Network> random(std::uint64_t seed);
+
+    private:
+        std::unique_ptr<std::int16_t[]> featureBias;
+        std::unique_ptr<std::int16_t[]> featureWeights;
+        std::unique_ptr<std::int32_t[]> l2Bias;
+        std::unique_ptr<std::int8_t[]> l2Weights;
+        std::unique_ptr<std::int32_t[]> l3Bias;
+        std::unique_ptr<std::int8_t[]> l3Weights;
+        std::int32_t outBias = 0;
+        std::unique_ptr<std::int8_t[]> outWeights;
+    };
+
+    // Network used by NnueEvaluate and the board accumulators, nullptr (the default) for none.
+    // Not to be changed while a search runs. Every change starts a new generation: accumulators of older
+    // generations are refreshed by their next update. SetNetwork returns the previous network
+    const Network* ActiveNetwork();
+    std::uint32_t NetworkGeneration();
+    std::unique_ptr<Network> SetNetwork(std::unique_ptr<Network> network);
+
+    // Score of pos for the player to move with the active network, in centi-pieces.
+    // Builds with HIGH_HIVE_VERIFY_EVAL check the board accumulator against a computation from scratch first
+    int NnueEvaluate(const Position& pos);
+
+    // Name of the kernels of this build: "avx2" or "scalar"
+    const char* NnueKernels();
+
+}
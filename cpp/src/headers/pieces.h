@@ -77,4 +77,34 @@ namespace Hive {
         return (col == Color::White) ? Color::Black : Color::White;
     }
 
+
+    // ----- Piece Indexing -----
+    // Every piece of a game is mapped to a dense index in [0, PIECE_COUNT):
+    // white pieces take [0, 14), black pieces take [14, 28).
+    // Within a color the order follows the Bug enum: Q, B1, B2, S1, S2, G1, G2, G3, A1, A2, A3, L, M, P
+    constexpr int PIECES_PER_COLOR = 14;
+    constexpr int PIECE_COUNT = 2 * PIECES_PER_COLOR;
+
+    // Number of copies of each bug in a hand, in Bug enum order
+    constexpr std::array<int, 8> BUG_COUNT = {1, 2, 2, 3, 3, 1, 1, 1};
+    // First index of each bug inside a color block, in Bug enum order
+    constexpr std::array<int, 8> BUG_OFFSET = {0, 1, 3, 5, 8, 11, 12, 13};
+
+    // Returns the dense index of a piece
+    constexpr int pieceIndex(const Piece& piece) {
+        const int bug = static_cast<int>(piece.bug);
+        const int slot = (BUG_COUNT[bug] == 1 || piece.id == 0) ? 0 : piece.id - 1;
+        return static_cast<int>(piece.color) * PIECES_PER_COLOR + BUG_OFFSET[bug] + slot;
+    }
+
+    // Returns the piece of a given dense index
+    constexpr Piece indexToPiece(int index) {
+        const Color color = (index < PIECES_PER_COLOR) ? Color::White : Color::Black;
+        const int local = index % PIECES_PER_COLOR;
+        int bug = 7;
+        while (BUG_OFFSET[bug] > local) --bug;
+        const auto id = static_cast<uint8_t>(BUG_COUNT[bug] == 1 ? 0 : local - BUG_OFFSET[bug] + 1);
+        return {color, static_cast<Bug>(bug), id};
+    }
+
 }
\ No newline at end of file
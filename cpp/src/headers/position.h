@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include "board.h"
+#include "pieces.h"
+#include "moves.h"
+
+// POSITION NOTATION
+// A Position is everything needed to resume a game without its move history:
+// the board, the game type, the player to move with the turn number, and the last moved piece (Pillbug rule).
+//
+// Text notation (a FEN analogue), fields separated by ';' like a UHP GameString:
+//     <GameType>;<TurnString>;<LastMoved>;<Stacks>;<WhiteHand>;<BlackHand>
+// where:
+// - GameType:   UHP GameTypeString, e.g. "Base+MLP"
+// - TurnString: UHP TurnString, e.g. "Black[3]"
+// - LastMoved:  UHP PieceString of the last moved piece, or "-"
+// - Stacks:     '/' separated list of "q,r=<pieces>", pieces listed from bottom to top (e.g. "0,1=wA1bB1").
+//               Coordinates are relative: the stacks are translated so that the smallest q and r are 0.
+// - Hands:      pieces still in hand without the color prefix (e.g. "QB1B2S1"), or "-" if empty
+//
+// Example:
+//     Base+MLP;White[3];bA1;0,0=wS1/1,0=bS1/2,0=bA1/0,1=wQ;B1B2S2G1G2G3A1A2A3LMP;QB1B2S2G1G2G3A2A3LMP
+//
+// Binary notation, all integers little endian:
+//     [0]      flags: bit0 turn player (0 White, 1 Black), bit1 has last moved, bit2 M, bit3 L, bit4 P
+//     [1..2]   turn number
+//     [3]      last moved piece index (see pieceIndex)
+//     [4..5]   white hand mask (bit i set = piece of local index i in hand)
+//     [6..7]   black hand mask
+//     [8]      number of stacks
+//     then, for each stack: q (int8), r (int8), height, piece indices from bottom to top
+
+namespace Hive {
+
+    struct Position {
+        Board board;
+        std::string gameType = "Base+MLP";
+        Color turnPlayer = Color::White;
+        int turnNumber = 1;
+        std::optional<Piece> lastMoved;
+        // Hands, as masks over the local piece indices [0, PIECES_PER_COLOR)
+        std::array<std::uint16_t, 2> hands = {0, 0};
+
+        // Returns the pieces in hand of a given player
+        std::vector<Piece> hand(Color player) const;
+
+        // Builds a Position from a bare board, deriving both hands from the pieces on it
+        static Position fromBoard(const Board& board, Color turnPlayer);
+
+
+        // ----- Make / Unmake -----
+        // play() applies a (legal) move and records what undo() needs to restore the previous Position
+        void play(const Move& move);
+        void undo();
+
+        // Zobrist key of the Position: pieces on the board and player to move.
+        // Hands are implied by the board, the last moved piece is not part of the key
+        std::uint64_t key() const {
+            return board.key() ^ (turnPlayer == Color::Black ? ZOBRIST_BLACK_TO_MOVE : 0);
+        }
+
+        // Last move played, or nullptr if none was played since the Position was created or loaded
+        const Move* lastMove() const {
+            return history.empty() ? nullptr : &history.back().move;
+        }
+
+        // Number of moves played since the Position was created or loaded
+        int ply() const {
+            return static_cast<int>(history.size());
+        }
+
+        // ----- Repetitions -----
+        // The Position keeps the keys of the earlier positions: those of the game before it was created or loaded
+        // since its last irreversible move (setGameKeys), then one per move played, with a count of each key kept
+        // by play() and undo(). play() looks the new position up in the counts, O(1) whatever the number of plies
+        // since the last placement, and records what it found in the move's undo entry: the queries below are
+        // O(1) too. A placement adds a piece for good, so no key from before it can come back: the counts need no
+        // reset at irreversible moves
+
+        // Sets the keys of the positions of the game before this one since its last placement, oldest first.
+        // Only before any move is played
+        void setGameKeys(const std::vector<std::uint64_t>& gameKeys);
+
+        // Keys of the earlier positions since the last irreversible move, oldest first: the setGameKeys argument
+        // of a search from this Position
+        std::vector<std::uint64_t> reversibleKeys() const {
+            return {keys.begin() + static_cast<std::ptrdiff_t>(reversibleFrom), keys.end()};
+        }
+
+        // Number of earlier occurrences of the position since the last irreversible move
+        int repetitions() const {
+            return history.empty() ? 0 : history.back().repetitions;
+        }
+
+        // Returns True if the position is a draw by repetition for a search whose root is ply plies earlier:
+        // it already occurred after the root, or twice before it (threefold repetition)
+        bool isRepetitionDraw(int ply) const {
+            if (history.empty()) return false;
+            const Undo& last = history.back();
+            return last.repetitions >= 2 || (last.repetitions == 1 && last.repetitionDistance < ply);
+        }
+
+        // All the legal moves of the player to move
+        std::vector<Move> generateMoves() const;
+
+        // The legal moves of the player to move split by kind: movements and throws, placements
+        std::vector<Move> generatePieceMoves() const;
+        std::vector<Move> generatePlacements() const;
+
+        // The legal moves of the player to move that change the surround of a Queen with at least minPressure
+        // occupied neighbors (see RuleEngine::generateQueenThreats)
+        std::vector<Move> generateQueenThreats(int minPressure = 0) const;
+
+        // Returns True if the Queen of a given player has all six neighbors occupied
+        bool isQueenSurrounded(Color player) const;
+
+        // Returns the number of occupied neighbors of the Queen of a given player, 0 if not placed yet
+        int queenPressure(Color player) const;
+
+    private:
+        struct Undo {
+            Move move;
+            std::optional<Piece> lastMoved;
+            bool savedAccumulator = false;  // The board accumulator before the move is on accumulators
+            std::size_t reversibleFrom = 0;
+            // Earlier occurrences of the position reached by the move, and the plies back to the last one
+            int repetitions = 0;
+            int repetitionDistance = 0;
+            // Index in keys of the previous occurrence of the key the move pushed, restored by undo
+            std::uint32_t previousLast = 0;
+        };
+        std::vector<Undo> history;
+        // Key of the position before each move, after the game keys; keys before reversibleFrom cannot recur
+        std::vector<std::uint64_t> keys;
+        std::size_t reversibleFrom = 0;
+
+        // Occurrences of each key of keys, and the index of the last one. Open addressing with linear probing,
+        // a slot is free when its count is 0; at most half full
+        struct KeyCount {
+            std::uint64_t key = 0;
+            std::uint32_t count = 0;
+            std::uint32_t last = 0;
+        };
+        std::vector<KeyCount> keyCounts;
+        std::size_t distinctKeys = 0;
+
+        // Slot of key, or the free slot where it would go
+        std::size_t findKey(std::uint64_t key) const;
+        // Counts key before play() appends it to keys, returning the index of its previous occurrence
+        std::uint32_t pushKey(std::uint64_t key);
+        // Uncounts keys.back() before it is popped
+        void popKey(std::uint32_t previousLast);
+        void rebuildKeyCounts(std::size_t capacity);
+
+        // Fills the repetition fields of the last undo entry
+        void countRepetitions();
+        // Network accumulators saved by play while a network is active, restored by undo
+        std::vector<NnueAccumulator> accumulators;
+    };
+
+    // Returns True if str is a UHP GameTypeString: "Base", or "Base+" followed by expansion letters in M, L, P order
+    bool IsGameType(const std::string& str);
+
+    // Converts a Position into its text notation
+    std::string PositionToString(const Position& position);
+
+    // Converts a text notation into a Position.
+    // Throws std::invalid_argument if the notation is malformed: unknown game type, or pieces on the board and in
+    // the hands other than the pieces of the game type, each listed once
+    Position StringToPosition(const std::string& str);
+
+    // Converts a Position into its binary notation
+    std::vector<std::uint8_t> PositionToBytes(const Position& position);
+
+    // Converts a binary notation into a Position.
+    // Throws std::invalid_argument if the notation is malformed, with the same piece checks as StringToPosition
+    Position BytesToPosition(const std::vector<std::uint8_t>& bytes);
+
+    // Hexadecimal encoding of the binary notation, for text protocols
+    std::string BytesToHex(const std::vector<std::uint8_t>& bytes);
+    std::vector<std::uint8_t> HexToBytes(const std::string& hex);
+
+}
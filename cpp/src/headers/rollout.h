@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "position.h"
+
+// ROLLOUT POLICY
+// Draws one legal move of the player to move without generating the move list, for random playouts.
+// A candidate is drawn first, among the movable pieces on top of the player's stacks and the placeable bugs
+// in hand, then one destination for it:
+// - a piece move is drawn by reservoir sampling over the targets of the piece, so that only the piece drawn
+//   pays for its reachability (and for the One Hive check);
+// - a placement is drawn by rejection sampling: a random own stack, a random direction, until the cell is a
+//   legal one. Cells next to several own stacks are a little more likely, which a playout does not mind.
+// A candidate without destination is dropped and another one is drawn, so the move is legal whenever one exists.
+//
+// Light heuristic: with an attack weight w > 1, a piece move next to the rival Queen is w times more likely
+// than any other destination of the piece (a placement never touches the rival Queen).
+//
+// Pillbug throws are never drawn, the first two placements of the game go through the full generation,
+// and so does the rare position where no candidate gives a move (the throws are then the only moves, or none).
+
+namespace Hive {
+
+    class RolloutPolicy {
+    public:
+        explicit RolloutPolicy(std::uint64_t seed = 0, double attackWeight = 1.0)
+            : rng(seed), attackWeight(attackWeight) {}
+
+        void setAttackWeight(double weight) {
+            attackWeight = weight;
+        }
+        double getAttackWeight() const {
+            return attackWeight;
+        }
+
+        // Draws a legal move of the player to move in pos, PASS_MOVE if there is none
+        Move sample(const Position& pos);
+
+        // Plays random moves from pos until a Queen is surrounded or maxPlies are played, then restores pos.
+        // Returns the result for the player to move in pos: 1 win, -1 loss, 0 draw or unfinished.
+        // plies receives the number of moves played
+        float playout(Position& pos, int maxPlies, int& plies);
+
+    private:
+        // A candidate: the coordinate of a movable piece, or the local index of a placeable bug in hand
+        struct Candidate {
+            bool placement = false;
+            Coord from{0, 0};
+            int local = 0;
+        };
+
+        bool samplePieceMove(const Position& pos, const Candidate& candidate, Move& move);
+        bool samplePlacement(const Position& pos, const Candidate& candidate, Move& move);
+
+        // Fallback: a uniform pick among the generated moves
+        Move sampleGenerated(const Position& pos);
+
+        std::mt19937_64 rng;
+        double attackWeight;
+
+        // ----- Scratch -----
+        std::vector<Candidate> candidates;
+        std::vector<Coord> ownStacks;
+        std::vector<Coord> targets;
+        Coord rivalQueen{0, 0};
+        bool rivalQueenPlaced = false;
+    };
+
+}
@@ -2,23 +2,58 @@
 
 #include "board.h"
 #include "moves.h"
+#include <optional>
 #include <vector>
 
 // RULES DECLARATION
 // The file declares the methods for retrieving the possible moves
-// TODO: Implement generateMoves, generatePlacements, generateMovements
-// TODO: Improve function declaration and description here in the header
 
 namespace Hive {
 
     class RuleEngine {
         public:
-            // Method that internally calls generatePlacements and generateMovements and returns all the moves found
-            static std::vector<Move> generateMoves(const Board& board, Color turnPlayer, const std::vector<Piece>& hand);
+            // Method that internally calls generatePlacements, generateMovements and generateThrows and returns all the moves found.
+            // lastMoved is the piece moved in the previous turn: it cannot be thrown, cannot move if it was thrown, and a Pillbug
+            // cannot throw right after being moved
+            static std::vector<Move> generateMoves(const Board& board, Color turnPlayer, const std::vector<Piece>& hand,
+                                                   const std::optional<Piece>& lastMoved = std::nullopt);
+
+            // Method for retrieving all the placements of the player.
+            // Only the lowest id of each bug in hand can be placed (UHP), the Queen cannot be placed as the first piece
+            // and must be placed within the first four pieces.
+            static std::vector<Move> generatePlacements(const Board& board, Color player, const std::vector<Piece>& hand);
+
+            // Method for retrieving the moves of generateMoves that are not placements: movements and Pillbug throws.
+            // With generatePlacements, lets a search generate the placements of a wide position on demand
+            static std::vector<Move> generatePieceMoves(const Board& board, Color turnPlayer, const std::optional<Piece>& lastMoved = std::nullopt);
+
+            // Method for retrieving only the moves that change a Queen surround in favor of the player: movements and Pillbug throws
+            // out of the neighborhood of the own Queen or into the neighborhood of the rival Queen (its cell included, for Beetles
+            // climbing on it), plus the own Queen movements. The opposite directions only lose ground and are left out, as
+            // placements are: a placement can never touch the rival Queen.
+            // Only the Queens with at least minPressure occupied neighbors are considered.
+            // Short-range pieces too far from the Queens are skipped before generating their targets, so the cost grows
+            // with the number of pieces near the Queens, not with the size of the hive.
+            static std::vector<Move> generateQueenThreats(const Board& board, Color turnPlayer, const std::optional<Piece>& lastMoved,
+                                                          int minPressure = 0);
 
             // Method aimed to retrieve whether a piece can move from coordinate fromIdx to coordinate toIdx
             // Returns True if the move is valid, otherwise False
             static bool canSlide(const Board& board, int fromIdx, int toIdx);
+
+            // ----- Single Move Queries -----
+            // For the samplers that draw one move without generating them all
+
+            // Method for retrieving whether the piece on top of coordinate from can leave it without breaking the One Hive Rule.
+            // ATTENTION: Runs isBoardConnected, a BFS, for pieces that are not on a stack or a leaf
+            static bool canLift(const Board& board, Coord from);
+
+            // Method for retrieving the destinations of the piece on top of coordinate from, by bug type
+            static void getTargets(const Board& board, Coord from, const Piece& piece, std::vector<Coord>& targets);
+
+            // Method for retrieving whether the player can place a piece on cell: empty, next to a stack of the player
+            // and not next to a rival one. Does not cover the first two placements of the game
+            static bool isPlacementCell(const Board& board, Color player, Coord cell);
         
         private:
             // Method for checking the One Hive Rule, i.e.,for retrieving whether a board is connected if a piece at coordinate idx is removed.
@@ -31,10 +66,18 @@ namespace Hive {
             // Otherwise, returns False
             static bool isBoardConnected(const Board& board, int idx);
 
-            // TODO
-            static std::vector<Move> generatePlacements(const Board& board, Color player, const std::vector<Piece>& hand);
-            // TODO
-            static std::vector<Move> generateMovements(const Board& board, Color player); 
+            // Method for retrieving all the movements of the pieces on top of the stacks of the player.
+            // Pieces can move only once the player's Queen is on the board, and not right after a Pillbug threw them (lastMoved).
+            static std::vector<Move> generateMovements(const Board& board, Color player, const std::optional<Piece>& lastMoved);
+
+            // Method for retrieving the Pillbug special ability moves: a Pillbug (or a Mosquito touching one) on the ground moves
+            // an adjacent single piece of either color to another empty cell adjacent to it, passing over itself.
+            // Moves already present in moves are not added twice.
+            static void generateThrows(const Board& board, Color player, const std::optional<Piece>& lastMoved, std::vector<Move>& moves);
+
+            // Method for retrieving whether a piece at the given level can pass between the two cells adjacent to both fromIdx and toIdx.
+            // Returns False if both cells are at least level high (3D gate)
+            static bool canPassAtLevel(const Board& board, int fromIdx, int toIdx, int level);
     };
 
 }
\ No newline at end of file
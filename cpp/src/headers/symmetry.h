@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "coords.h"
+#include "moves.h"
+#include "position.h"
+
+// POSITION SYMMETRIES
+// A Hive position keeps its value under translation and under the 12 rotations and reflections of the grid
+// (see transformCoord). Its canonical orientation is the symmetry giving the smallest key, the hive translated
+// so that its first cell (smallest r, then q) is the origin: a cell c maps to transformCoord(c, symmetry) - anchor.
+// The canonical key is the Zobrist key of the pieces in that orientation with the player to move (see
+// zobrist.h), the same for all the symmetric and translated copies of a position. As Position::key, it leaves
+// out the last moved piece. Canonicalize costs 12 passes over the occupied cells: meant for the root, the
+// opening book and tools, not for every node.
+
+namespace Hive {
+
+    // The canonical key of a position and the transform into its canonical orientation
+    struct Canonical {
+        std::uint64_t key = 0;
+        int symmetry = 0;
+        Coord anchor;
+
+        // From the position's orientation to the canonical one, and back
+        Coord apply(Coord c) const {
+            return transformCoord(c, symmetry) - anchor;
+        }
+        Coord undo(Coord c) const {
+            return transformCoord(c + anchor, inverseSymmetry(symmetry));
+        }
+        Move apply(Move move) const;
+        Move undo(Move move) const;
+
+        // The position in the canonical orientation
+        Position apply(const Position& pos) const;
+    };
+
+    Canonical Canonicalize(const Position& pos);
+
+    inline std::uint64_t CanonicalKey(const Position& pos) {
+        return Canonicalize(pos).key;
+    }
+
+    // Collapses symmetric equivalents: drops every move that leads to a symmetric image of the position left by
+    // an earlier move of the same piece. Keeps the order of the moves it keeps
+    std::vector<Move> UniqueMoves(const Position& pos, const std::vector<Move>& moves);
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "engine.h"
+#include "moves.h"
+
+// TIME MANAGEMENT
+// Splits the budget of a bestmove (SearchLimits::moveTime) into two deadlines:
+// - hard: the search is stopped, whatever it is doing. It leaves a margin of the move time for the reply;
+// - soft: no new iteration starts past it. It starts at half the hard deadline (an iteration takes about as
+//   long as all the previous ones together) and is rescaled after every iteration:
+//     - shortened while the best move stays the same, down to STABILITY_SCALE.back() after 4 iterations;
+//     - lengthened when the best move just changed, or when the score dropped since the previous iteration.
+// The Watchdog raises the stop flag of a search at its hard deadline from a thread of its own, so that the
+// reply never depends on the search checking the clock.
+
+namespace Hive {
+
+    class TimeManager {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Starts the clock of a search with the given budget
+        void start(const SearchLimits& limits);
+
+        // Called by the main thread after each completed iteration.
+        // Returns True if the search should not start another one
+        bool iterationDone(const Move& bestMove, int score);
+
+        // Returns False for a search bounded by depth only (see NO_TIME_LIMIT)
+        bool timed() const {
+            return isTimed;
+        }
+
+        Clock::time_point hardDeadline() const {
+            return startTime + hardLimit;
+        }
+
+        std::chrono::milliseconds softLimit() const {
+            return soft;
+        }
+
+        std::chrono::milliseconds elapsed() const {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime);
+        }
+
+    private:
+        Clock::time_point startTime;
+        std::chrono::milliseconds hardLimit{0};
+        std::chrono::milliseconds soft{0};
+        bool isTimed = true;
+
+        int iterations = 0;
+        int stableIterations = 0;   // Consecutive iterations that ended on the same best move
+        Move lastBest = PASS_MOVE;
+        int lastScore = 0;
+    };
+
+    // Raises a stop flag at a deadline, unless cancelled first
+    class Watchdog {
+    public:
+        Watchdog(std::atomic<bool>& stop, TimeManager::Clock::time_point deadline);
+        ~Watchdog();
+
+        Watchdog(const Watchdog&) = delete;
+        Watchdog& operator=(const Watchdog&) = delete;
+
+        // Returns True if the deadline was reached
+        bool fired() const {
+            return hasFired.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool cancelled = false;
+        std::atomic<bool> hasFired{false};
+        std::thread thread;
+    };
+
+}
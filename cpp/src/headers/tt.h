@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "largepages.h"
+#include "moves.h"
+
+// TRANSPOSITION TABLE
+// Power-of-two array of cache-line buckets, each holding BUCKET_SIZE packed 16-byte entries.
+// An entry stores (key ^ data, data), where data packs:
+//     bits [0, 32)  packed move (see PackMove)
+//     bits [32, 48) score
+//     bits [48, 56) depth
+//     bits [56, 58) bound
+//     bits [58, 64) age (search generation)
+// Threads share the table without locks: a torn write (key from one store, data from another)
+// fails the key ^ data check and reads as a miss (Hyatt's lockless hashing).
+// The buckets are mapped on large pages by the first allocate() (see largepages.h).
+
+namespace Hive {
+
+    // Probe statistics of the shared tables are sampled: returns True for one call in STATS_SAMPLE of the thread
+    constexpr std::uint32_t STATS_SAMPLE = 16;
+    inline bool SampleProbe() {
+        thread_local std::uint32_t tick = 0;
+        return (++tick & (STATS_SAMPLE - 1)) == 0;
+    }
+
+    enum class Bound : std::uint8_t {
+        None = 0,
+        Upper = 1,  // All-node: score <= stored score
+        Lower = 2,  // Cut-node: score >= stored score
+        Exact = 3
+    };
+
+    // Unpacked content of an entry
+    struct TTData {
+        std::uint32_t move = 0;
+        int score = 0;
+        int depth = 0;
+        Bound bound = Bound::None;
+    };
+
+    class TranspositionTable {
+    public:
+        static constexpr int BUCKET_SIZE = 4;
+        static constexpr std::size_t DEFAULT_SIZE_MB = 64;
+
+        explicit TranspositionTable(std::size_t sizeMB = DEFAULT_SIZE_MB);
+
+        // Resizes the table to the largest power-of-two bucket count fitting in sizeMB. Clears the content
+        void resize(std::size_t sizeMB);
+        void clear();
+
+        // Maps the buckets if not done yet, before the first probe or store. Returns True if it mapped them
+        bool allocate() {
+            return buckets.allocate();
+        }
+        PageBacking backing() const {
+            return buckets.backing();
+        }
+
+        // Called once per search: entries of older searches become preferred victims
+        void newSearch() {
+            generation = (generation + 1) & AGE_MASK;
+        }
+
+        // Returns True and fills out if key is in the table
+        bool probe(std::uint64_t key, TTData& out);
+
+        // Stores an entry, replacing the least valuable one of the bucket (lowest depth, oldest age)
+        void store(std::uint64_t key, std::uint32_t move, int score, int depth, Bound bound);
+
+        // ----- Statistics -----
+        std::size_t sizeMB() const {
+            return bucketCount * sizeof(Bucket) >> 20;
+        }
+
+        // Permille of sampled entries written during the current search
+        int hashfull() const;
+
+        // Permille of probes that found their key since the last clear, estimated on the sampled probes
+        int hitRate() const;
+
+    private:
+        struct Entry {
+            std::atomic<std::uint64_t> keyXorData{0};
+            std::atomic<std::uint64_t> data{0};
+        };
+
+        struct alignas(64) Bucket {
+            std::array<Entry, BUCKET_SIZE> entries;
+        };
+        static_assert(sizeof(Bucket) == 64, "A bucket must fill exactly one cache line");
+
+        static constexpr std::uint8_t AGE_MASK = 0x3F;
+
+        static std::uint64_t pack(std::uint32_t move, int score, int depth, Bound bound, std::uint8_t age);
+        static TTData unpack(std::uint64_t data);
+        static std::uint8_t ageOf(std::uint64_t data) {
+            return static_cast<std::uint8_t>(data >> 58);
+        }
+
+        Bucket& bucketOf(std::uint64_t key) {
+            return buckets[key & (bucketCount - 1)];
+        }
+
+        LargePageArray<Bucket> buckets;
+        std::size_t bucketCount = 0;
+        std::uint8_t generation = 0;
+
+        // Counted for one probe in STATS_SAMPLE of each thread (see SampleProbe): every thread counting every
+        // probe would keep the counters' line moving between cores. Away from the fields read by probes
+        struct alignas(64) Stats {
+            std::atomic<std::uint64_t> probes{0};
+            std::atomic<std::uint64_t> hits{0};
+        };
+        Stats stats;
+    };
+
+}
@@ -3,10 +3,20 @@
 #include <string>
 #include <vector>
 #include <memory>  // Required for std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <random>
 #include "board.h"
 #include "utils.h"
 #include "rules.h"
+#include "position.h"
 #include "engine.h" // Include the new engine header
+#include "alphabeta.h"
+#include "mcts.h"
+#include "dfpn.h"
+#include "eval.h"
+#include "nnue.h"
+#include "book.h"
 
 namespace Hive {
 
@@ -19,17 +29,84 @@ namespace Hive {
         int turnNumber = 1;
         Color turnPlayer = Color::White;
         std::vector<std::string> moveHistory;
+        std::optional<Piece> lastMoved;
+
+        // Keys of the positions before each move since the last placement (see Position::setGameKeys), given to
+        // the engine for its repetition detection
+        std::vector<std::uint64_t> gameKeys;
+        // Records the current position before a move, or forgets them all before an irreversible one
+        void recordGameKey(bool irreversible);
 
         std::string generateGameString() const;
         void applyMove(const std::string& moveStr);
 
-        // The polymorphic engine instance, initialized as RandomEngine
-        std::unique_ptr<Engine> engine = std::make_unique<RandomEngine>();
+        // Snapshot of the current game as a Position, and its inverse
+        Position currentPosition() const;
+        void loadPosition(const Position& position);
+
+        // The polymorphic engine instance, initialized as AlphaBetaEngine.
+        // Selected with the "Engine" option, handled here: switching engine resets the engine options
+        std::unique_ptr<Engine> engine = std::make_unique<AlphaBetaEngine>();
+        std::string engineName = "AlphaBeta";
+
+        // Returns a new engine by "Engine" option value, nullptr if unknown
+        static std::unique_ptr<Engine> CreateEngine(const std::string& name);
+
+        // Weights file of the evaluation (see eval.h), "EvalFile" option handled here: shared by all the engines.
+        // An empty path restores the default weights
+        std::string evalFile;
+        bool loadEvalFile(const std::string& path);
+
+    public:
+        // Weights file of the network evaluation (see nnue.h), "NnueFile" option handled here: the engines use
+        // the network instead of the handcrafted evaluation while one is loaded. An empty path unloads it.
+        // Also called at startup with the "--nnue <file>" argument. Returns False, with an "err" line, on failure
+        bool loadNnueFile(const std::string& path);
+
+        // Opening book (see book.h), "BookFile" option handled here: bestmove plays a book move, when the book has
+        // a legal one for the current position, without starting a search. An empty path closes the book.
+        // Also called at startup with the "--book <file>" argument. Returns False, with an "err" line, on failure
+        bool loadBookFile(const std::string& path);
+
+    private:
+        std::string nnueFile;
+
+        std::unique_ptr<OpeningBook> book;
+        std::string bookFile;
+        std::mt19937_64 bookRng{std::random_device{}()};
+
+        // "Ponder" option, handled here: between two commands, the engine searches the current position with
+        // infinite limits, stopped when the next command needs the engine. The next bestmove finds its results in
+        // the transposition table or the tree (reused one move later). Engines that cannot be interrupted
+        // (Engine::canPonder) do not ponder
+        bool ponder = false;
+        void startPonder();
+
+        // ----- Search Thread -----
+        // bestmove and the ponder search run on searchThread, one at a time, while the loop goes on reading
+        // commands. A bestmove prints its own reply. Every write to std::cout holds outputMutex, so that replies
+        // never interleave
+        std::thread searchThread;
+        bool pondering = false;
+        std::mutex outputMutex;
+        void startSearch(const SearchLimits& limits, std::vector<Piece> hand, std::vector<Move> validMoves, bool isPonder);
+        // Interrupts the search (Engine::stop) and waits for it
+        void stopSearch();
+        // Waits for a bestmove to end, interrupts a ponder search
+        void finishSearch();
+
+        // Returns True for the commands answered at once, even during a search: u1, info, options (not set)
+        static bool isImmediate(const std::vector<std::string>& chunks);
 
         std::vector<Piece> getHand(Color player) const;
 
     public:
         UhpHandler() = default;
+        ~UhpHandler();
+
+        // Processes commands until "exit" or the end of the input. A reader thread feeds them through a
+        // CommandQueue (see commandqueue.h), so that the loop keeps answering during a search.
+        // Extension: "stop" interrupts a running bestmove, which replies at once with its best move so far
         void loop();
 
     private:
@@ -40,11 +117,29 @@ namespace Hive {
         void cmdPlay(const std::vector<std::string>& chunks, const std::string& line);
         void cmdPass();
         void cmdValidMoves() const;
-        void cmdBestMove(const std::vector<std::string>& chunks) const;
+        void cmdBestMove(const std::vector<std::string>& chunks);
+
+        // Budget of "bestmove", "bestmove time hh:mm:ss" or "bestmove depth N".
+        // A depth bounds the search alone: no time limit. Returns False if the arguments are malformed
+        static bool ParseSearchLimits(const std::vector<std::string>& chunks, SearchLimits& limits);
+
+        // Extension: "position [bin] [<notation>]" emits or loads a Position (see position.h)
+        void cmdPosition(const std::vector<std::string>& chunks);
+
+        // Extension: "bench smp [depth] [maxThreads]", "bench order [depth]" or
+        // "bench mcts [moveTimeMs] [maxThreads] [games]" runs a benchmark (see bench.h)
+        static void cmdBench(const std::vector<std::string>& chunks);
 
         static void cmdUndo();
 
-        static void cmdOptions();
+        // "options", "options get <Name>", "options set <Name> <Value>"
+        // Extension: the file options (EvalFile, NnueFile, BookFile) have the type "path", which UHP does not define.
+        // They are answered by get and set but left out of the plain listing. Their value is the rest of the line,
+        // spaces included; a missing value or "" sets an empty path
+        void cmdOptions(const std::vector<std::string>& chunks, const std::string& line);
+        std::vector<EngineOption> allOptions() const;
+        static std::string OptionToString(const EngineOption& option);
+        static constexpr const char* PATH_OPTION = "path";
     };
 
 } // namespace Hive
\ No newline at end of file
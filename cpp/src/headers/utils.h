@@ -2,6 +2,8 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
+#include <stdexcept>
 #include "board.h"
 #include "moves.h"
 #include "coords.h"
@@ -14,16 +16,16 @@ namespace Hive {
     bool findPieceOnBoard(const Board& board, const Piece& targetPiece, Coord& outCoord);
 
     // Converts a Piece into a valid UHP string
-    inline std::string PieceToString(const Piece& piece);
+    std::string PieceToString(const Piece& piece);
 
     // Converts a UHP piece string into a defined Piece element
-    inline Piece StringToPiece(const std::string_view str);
+    Piece StringToPiece(const std::string_view str);
 
     // Converts a Coordinate (Piece + Direction) to a valid UHP string
-    inline std::string CoordToString(const Coord& pieceCoord, const Coord& neighCoord, const std::string& neighName);
+    std::string CoordToString(const Coord& pieceCoord, const Coord& neighCoord, const std::string& neighName);
 
     // Converts a Move to a valid UHP string
-    inline std::string MoveToString(const Move& move, const Board& board);
+    std::string MoveToString(const Move& move, const Board& board);
 
     // Converts a UHP move string to a Move
     Move StringToMove(const std::string& moveStr, const Board& board);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// ZOBRIST KEYS
+// Position keys are the XOR of one key per (piece, cell, stack level) plus a key for the player to move.
+// Keys are derived on the fly with the splitmix64 finalizer instead of being read from a table:
+// a full table would need PIECE_COUNT * BOARD_AREA * MAX_STACK entries (5.5 MB), far from any cache.
+
+namespace Hive {
+
+    // splitmix64 finalizer: a bijective, well-mixed 64-bit hash
+    constexpr std::uint64_t splitmix64(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Key of a piece (see pieceIndex) at a grid index and stack level (0 = ground)
+    constexpr std::uint64_t zobristPiece(int piece, int cell, int level) {
+        return splitmix64((static_cast<std::uint64_t>(piece) << 20) | (static_cast<std::uint64_t>(level) << 16) | static_cast<std::uint64_t>(cell));
+    }
+
+    // Key XORed in when Black is to move
+    constexpr std::uint64_t ZOBRIST_BLACK_TO_MOVE = splitmix64(1ULL << 40);
+
+}
@@ -0,0 +1,95 @@
+#include "headers/largepages.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace Hive {
+
+    namespace {
+        constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+        std::atomic<bool> largePages{true};
+
+        std::size_t roundUp(std::size_t bytes, std::size_t alignment) {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+        void* mapAnonymous(std::size_t bytes, int extraFlags) {
+            void* memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+            return memory == MAP_FAILED ? nullptr : memory;
+        }
+
+        // A mapping of bytes (a multiple of HUGE_PAGE_SIZE) starting on a huge page boundary: a larger mapping
+        // trimmed on both sides, so that the kernel can back every 2 MB of it with a huge page
+        void* mapAligned(std::size_t bytes) {
+            auto* raw = static_cast<char*>(mapAnonymous(bytes + HUGE_PAGE_SIZE, 0));
+            if (!raw) return nullptr;
+            const auto address = reinterpret_cast<std::uintptr_t>(raw);
+            char* aligned = raw + (roundUp(address, HUGE_PAGE_SIZE) - address);
+            if (aligned > raw) ::munmap(raw, static_cast<std::size_t>(aligned - raw));
+            const std::size_t tail = static_cast<std::size_t>(raw + bytes + HUGE_PAGE_SIZE - (aligned + bytes));
+            if (tail > 0) ::munmap(aligned + bytes, tail);
+            return aligned;
+        }
+    }
+
+    const char* PageBackingName(PageBacking backing) {
+        switch (backing) {
+            case PageBacking::Explicit: return "explicit";
+            case PageBacking::Transparent: return "transparent";
+            case PageBacking::Regular: return "regular";
+            default: return "none";
+        }
+    }
+
+    std::string PagesInfo(const std::string& table, std::size_t sizeMB, PageBacking backing) {
+        return "info pages " + table + " " + std::to_string(sizeMB) + " " + PageBackingName(backing);
+    }
+
+    void SetLargePages(bool enabled) {
+        largePages.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool LargePagesEnabled() {
+        return largePages.load(std::memory_order_relaxed);
+    }
+
+    void* AllocateLargePages(std::size_t bytes, PageBacking& backing, std::size_t& mappedBytes) {
+        bytes = std::max<std::size_t>(bytes, 1);
+
+        if (LargePagesEnabled() && bytes >= HUGE_PAGE_SIZE) {
+            const std::size_t hugeBytes = roundUp(bytes, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+            if (void* memory = mapAnonymous(hugeBytes, MAP_HUGETLB)) {
+                backing = PageBacking::Explicit;
+                mappedBytes = hugeBytes;
+                return memory;
+            }
+#endif
+#ifdef MADV_HUGEPAGE
+            if (void* memory = mapAligned(hugeBytes)) {
+                // Without transparent huge pages in the kernel, madvise fails and the mapping stays regular
+                backing = (::madvise(memory, hugeBytes, MADV_HUGEPAGE) == 0) ? PageBacking::Transparent : PageBacking::Regular;
+                mappedBytes = hugeBytes;
+                return memory;
+            }
+#endif
+        }
+
+        void* memory = mapAnonymous(bytes, 0);
+        if (!memory) throw std::bad_alloc();
+        backing = PageBacking::Regular;
+        mappedBytes = bytes;
+        return memory;
+    }
+
+    void FreeLargePages(void* memory, std::size_t mappedBytes) {
+        // Every backing is a mapping
+        if (memory) ::munmap(memory, mappedBytes);
+    }
+
+}
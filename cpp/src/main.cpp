@@ -1,13 +1,24 @@
 #include <iostream>
+#include <string>
 #include "headers/uhp.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     // Disable synchronization between C and C++ standard streams for engine STDIO speed
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
+    // The search and ponder threads report to std::cerr: tied, each report would flush std::cout from their thread,
+    // outside the handler's output lock
+    std::cerr.tie(nullptr);
 
-    // Instantiate and trap process inside the communication loop
     Hive::UhpHandler uhp;
+
+    // "--nnue <file>": network weights loaded at startup (see nnue.h), "--book <file>": opening book (see book.h)
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--nnue" && !uhp.loadNnueFile(argv[i + 1])) return 1;
+        if (std::string(argv[i]) == "--book" && !uhp.loadBookFile(argv[i + 1])) return 1;
+    }
+
+    // Trap process inside the communication loop
     uhp.loop();
 
     return 0;
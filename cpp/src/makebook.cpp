@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "headers/analysis.h"
+#include "headers/book.h"
+
+// Opening book builder (see book.h):
+//     high_hive_book <book file> [--games <games file>] [--selfplay N [--depth N] [--random-plies N] [--seed N]]
+//                    [--plies N] [--min-weight N] [--threads N]
+// The games of --games (see analysis.h for the format) and N self-play games are counted together.
+// The progress and errors go to stderr.
+
+namespace {
+    void usage() {
+        std::cerr << "usage: high_hive_book <book file> [--games <games file>] [--selfplay N [--depth N] [--random-plies N]"
+                     " [--seed N]] [--plies N] [--min-weight N] [--threads N]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+
+    std::string output;
+    std::string gamesFile;
+    int selfPlay = 0;
+    int depth = 3;
+    int randomPlies = 2;
+    std::uint64_t seed = 1;
+    int plies = Hive::BookBuilder::DEFAULT_MAX_PLY;
+    std::uint32_t minWeight = 1;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--games" && hasValue) gamesFile = argv[++i];
+            else if (arg == "--selfplay" && hasValue) selfPlay = std::stoi(argv[++i]);
+            else if (arg == "--depth" && hasValue) depth = std::stoi(argv[++i]);
+            else if (arg == "--random-plies" && hasValue) randomPlies = std::stoi(argv[++i]);
+            else if (arg == "--seed" && hasValue) seed = std::stoull(argv[++i]);
+            else if (arg == "--plies" && hasValue) plies = std::stoi(argv[++i]);
+            else if (arg == "--min-weight" && hasValue) minWeight = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--threads" && hasValue) threads = std::stoi(argv[++i]);
+            else if (output.empty() && arg.rfind("--", 0) != 0) output = arg;
+            else {
+                usage();
+                return 1;
+            }
+        }
+        if (output.empty() || (gamesFile.empty() && selfPlay < 1) || selfPlay < 0 || depth < 1 || randomPlies < 0 ||
+            plies < 1 || threads < 1) {
+            usage();
+            return 1;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Hive::BookBuilder builder(plies);
+        if (!gamesFile.empty()) {
+            const std::vector<Hive::Analysis::Game> games = Hive::Analysis::readGames(gamesFile, std::cerr);
+            builder.merge(Hive::BookBuilder::fromGames(games, plies, threads));
+            std::cerr << "counted " << games.size() << " games" << std::endl;
+        }
+        if (selfPlay > 0) {
+            builder.merge(Hive::BookBuilder::fromSelfPlay(selfPlay, depth, randomPlies, plies, threads, seed));
+            std::cerr << "played " << selfPlay << " games at depth " << depth << std::endl;
+        }
+
+        builder.write(output, minWeight);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "wrote " << output << ": " << builder.positions() << " positions in " << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "err " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,985 @@
+#include "headers/mcts.h"
+#include "headers/eval.h"
+#include "headers/evalqueue.h"
+#include "headers/symmetry.h"
+#include "headers/timeman.h"
+#include "headers/utils.h"
+#include "headers/zobrist.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <unordered_set>
+
+namespace Hive {
+
+    namespace {
+        // Share of the tree budget given to the edges: an expanded node has tens of edges
+        constexpr std::size_t EDGE_SHARE_NUM = 15;
+        constexpr std::size_t EDGE_SHARE_DEN = 16;
+
+        // First play urgency: an unvisited child is assumed this much worse than its parent
+        constexpr float FPU_REDUCTION = 0.2f;
+
+        // A pool filled to HIGH_WATER_NUM / HIGH_WATER_DEN triggers a compaction
+        constexpr std::size_t HIGH_WATER_NUM = 15;
+        constexpr std::size_t HIGH_WATER_DEN = 16;
+
+        // Playouts between two clock checks
+        constexpr std::uint64_t TIME_CHECK_PLAYOUTS = 64;
+
+        // Heuristic evaluator
+        constexpr float VALUE_SCALE = 0.0035f;      // tanh argument per centi-piece of evaluation
+        constexpr float ATTACK_LOGIT = 1.5f;        // Move next to the rival Queen
+        constexpr float SELF_BLOCK_LOGIT = -1.0f;   // Move next to the own Queen
+
+        constexpr int MAX_PV = 16;
+
+        // Progressive widening: open edges = WIDENING_BASE + WIDENING_FACTOR * sqrt(visits)
+        constexpr float WIDENING_BASE = 4.0f;
+        constexpr float WIDENING_FACTOR = 2.0f;
+        // Placements of the first expansion of a node, the next batches double
+        constexpr std::size_t PLACEMENT_BATCH = 8;
+
+        // Node table entries per node of the arena: keeps the probe sequences short
+        constexpr std::size_t TABLE_SLOTS_PER_NODE = 2;
+        constexpr std::uint64_t LAST_MOVED_SALT = 1ULL << 41;
+
+        // Cheap placement ranking for lazy generation: closest to the rival Queen first
+        void SortPlacements(const Position& pos, std::vector<Move>& placements) {
+            Coord rivalQueen;
+            if (!pos.board.locate({rival(pos.turnPlayer), Bug::Queen, 0}, rivalQueen)) return;
+            std::stable_sort(placements.begin(), placements.end(), [&](const Move& a, const Move& b) {
+                return hexDistance(a.to, rivalQueen) < hexDistance(b.to, rivalQueen);
+            });
+        }
+
+        // Key of a position in the node table. Position::key() leaves out the last moved piece, but it
+        // restricts the Pillbug throws: positions differing by it have different moves
+        std::uint64_t GraphKey(const Position& pos) {
+            const std::uint64_t key = pos.key();
+            return pos.lastMoved ? key ^ splitmix64(LAST_MOVED_SALT | static_cast<std::uint64_t>(pieceIndex(*pos.lastMoved))) : key;
+        }
+    }
+
+    // ----- Heuristic Evaluator -----
+
+    float HeuristicEvaluator::evaluate(const Position& pos, const std::vector<Move>& moves, std::vector<float>& priors) {
+        const Color player = pos.turnPlayer;
+
+        Coord ownQueen, rivalQueen;
+        const bool ownPlaced = pos.board.locate({player, Bug::Queen, 0}, ownQueen);
+        const bool rivalPlaced = pos.board.locate({rival(player), Bug::Queen, 0}, rivalQueen);
+
+        priors.resize(moves.size());
+        float sum = 0.0f;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            const Move& m = moves[i];
+            float logit = 0.0f;
+            if (m.type != Move::Pass) {
+                if (rivalPlaced && hexDistance(m.to, rivalQueen) <= 1) logit += ATTACK_LOGIT;
+                if (ownPlaced && hexDistance(m.to, ownQueen) == 1) logit += SELF_BLOCK_LOGIT;
+            }
+            priors[i] = std::exp(logit);
+            sum += priors[i];
+        }
+        for (float& p : priors) p /= sum;
+
+        if (cache == nullptr || !cache->enabled()) {
+            const int score = ActiveNetwork() ? NnueEvaluate(pos) : Evaluate(pos);
+            return std::tanh(VALUE_SCALE * static_cast<float>(score));
+        }
+
+        const std::uint64_t key = EvalCacheKey(pos);
+        int score;
+        if (!cache->probe(key, score)) {
+            score = ActiveNetwork() ? NnueEvaluate(pos) : Evaluate(pos);
+            cache->store(key, score);
+        }
+        return std::tanh(VALUE_SCALE * static_cast<float>(score));
+    }
+
+    // ----- Node Arena -----
+
+    void NodeArena::reset(std::size_t sizeMB) {
+        const std::size_t bytes = std::max<std::size_t>(sizeMB, 1) << 20;
+        nodeCapacity = bytes * (EDGE_SHARE_DEN - EDGE_SHARE_NUM) / EDGE_SHARE_DEN / sizeof(Node);
+        edgeCapacity = bytes * EDGE_SHARE_NUM / EDGE_SHARE_DEN / sizeof(Edge);
+
+        // Default initialization once mapped: the elements are written by allocNode / allocEdges only
+        nodes.reset(nodeCapacity);
+        edges.reset(edgeCapacity);
+        clear();
+    }
+
+    void NodeArena::clear() {
+        nodeTop.store(0, std::memory_order_relaxed);
+        edgeTop.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint32_t NodeArena::allocNode(std::uint64_t key) {
+        const std::size_t idx = nodeTop.fetch_add(1, std::memory_order_relaxed);
+        if (idx >= nodeCapacity) return NO_NODE;
+
+        Node& n = nodes[idx];
+        n.key = key;
+        n.firstEdge = 0;
+        n.edgeCount = 0;
+        n.state.store(Unexpanded, std::memory_order_relaxed);
+        n.visits.store(0, std::memory_order_relaxed);
+        n.virtualLoss.store(0, std::memory_order_relaxed);
+        n.valueSum.store(0.0f, std::memory_order_relaxed);
+        n.utility = 0.0f;
+        return static_cast<std::uint32_t>(idx);
+    }
+
+    std::uint32_t NodeArena::allocEdges(std::uint32_t count) {
+        const std::size_t first = edgeTop.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > edgeCapacity) return NO_NODE;
+        return static_cast<std::uint32_t>(first);
+    }
+
+    std::vector<std::uint32_t> NodeArena::mark(std::uint32_t root, std::uint32_t minVisits, std::vector<bool>& live) const {
+        live.assign(nodeCount(), false);
+        std::vector<std::uint32_t> kept = {root};
+        live[root] = true;
+        for (size_t head = 0; head < kept.size(); ++head) {
+            const Node& n = nodes[kept[head]];
+            for (std::uint32_t i = 0; i < n.edgeCount; ++i) {
+                const std::uint32_t child = edges[n.firstEdge + i].child.load(std::memory_order_relaxed);
+                if (child == NO_NODE || child == CLAIMED || live[child]) continue;
+                if (nodes[child].visits.load(std::memory_order_relaxed) < minVisits) continue;
+                live[child] = true;
+                kept.push_back(child);
+            }
+        }
+        return kept;
+    }
+
+    std::pair<std::size_t, std::size_t> NodeArena::liveSize(std::uint32_t root, std::uint32_t minVisits) const {
+        std::vector<bool> live;
+        const std::vector<std::uint32_t> kept = mark(root, minVisits, live);
+        std::size_t edgeTotal = 0;
+        for (std::uint32_t n : kept) edgeTotal += nodes[n].edgeCount;
+        return {kept.size(), edgeTotal};
+    }
+
+    std::size_t NodeArena::compact(std::uint32_t root, std::uint32_t minVisits, std::vector<std::uint32_t>& remap) {
+        std::vector<bool> live;
+        std::vector<std::uint32_t> kept = mark(root, minVisits, live);
+
+        // Edges first, in address order: every kept range moves down (or stays), never over a range still to move
+        std::sort(kept.begin(), kept.end(), [&](std::uint32_t a, std::uint32_t b) { return nodes[a].firstEdge < nodes[b].firstEdge; });
+        std::size_t edgeNext = 0;
+        for (std::uint32_t n : kept) {
+            Node& node = nodes[n];
+            for (std::uint32_t i = 0; i < node.edgeCount; ++i) {
+                const Edge& from = edges[node.firstEdge + i];
+                Edge& to = edges[edgeNext + i];
+                if (&to == &from) continue;
+                to.move = from.move;
+                to.prior = from.prior;
+                to.child.store(from.child.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            node.firstEdge = static_cast<std::uint32_t>(edgeNext);
+            edgeNext += node.edgeCount;
+        }
+
+        // Then the nodes, in index order
+        const std::size_t count = live.size();
+        remap.assign(count, NO_NODE);
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!live[i]) continue;
+            remap[i] = static_cast<std::uint32_t>(next);
+            if (i != next) {
+                const Node& from = nodes[i];
+                Node& to = nodes[next];
+                to.key = from.key;
+                to.firstEdge.store(from.firstEdge.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.edgeCount.store(from.edgeCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.state.store(from.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.virtualLoss.store(0, std::memory_order_relaxed);
+                to.valueSum.store(from.valueSum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.utility = from.utility;
+            }
+            ++next;
+        }
+
+        // Finally the links, to the new indices
+        for (std::size_t i = 0; i < next; ++i) {
+            const Node& node = nodes[i];
+            for (std::uint32_t j = 0; j < node.edgeCount; ++j) {
+                Edge& e = edges[node.firstEdge + j];
+                const std::uint32_t child = e.child.load(std::memory_order_relaxed);
+                e.child.store((child == NO_NODE || child == CLAIMED) ? NO_NODE : remap[child], std::memory_order_relaxed);
+            }
+        }
+
+        nodeTop.store(next, std::memory_order_relaxed);
+        edgeTop.store(edgeNext, std::memory_order_relaxed);
+        return count - next;
+    }
+
+    // ----- Node Table -----
+
+    void NodeTable::reset(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.reset(size);
+        mask = size - 1;
+    }
+
+    bool NodeTable::allocate() {
+        if (!slots.allocate()) return false;
+        clear();
+        return true;
+    }
+
+    void NodeTable::clear() {
+        if (!slots.allocated()) return;
+        for (std::size_t i = 0; i <= mask; ++i) {
+            slots[i].key.store(0, std::memory_order_relaxed);
+            slots[i].node.store(NodeArena::NO_NODE, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint32_t NodeTable::find(std::uint64_t key) const {
+        if (key == 0) key = 1;
+        for (std::size_t i = key & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes) {
+            const std::uint64_t k = slots[i].key.load(std::memory_order_acquire);
+            if (k == key) return slots[i].node.load(std::memory_order_acquire);
+            if (k == 0) break;
+        }
+        return NodeArena::NO_NODE;
+    }
+
+    std::uint32_t NodeTable::insert(std::uint64_t key, std::uint32_t node) {
+        if (key == 0) key = 1;
+        for (std::size_t i = key & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes) {
+            Slot& slot = slots[i];
+            std::uint64_t k = slot.key.load(std::memory_order_acquire);
+            if (k == 0 && slot.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+                slot.node.store(node, std::memory_order_release);
+                return node;
+            }
+            if (k == key) {
+                const std::uint32_t existing = slot.node.load(std::memory_order_acquire);
+                return existing == NodeArena::NO_NODE ? node : existing;
+            }
+        }
+        return node;    // Table full: the node stays out of it
+    }
+
+    void NodeTable::remap(const std::vector<std::uint32_t>& newIndex) {
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> kept;
+        for (std::size_t i = 0; i <= mask; ++i) {
+            const std::uint64_t key = slots[i].key.load(std::memory_order_relaxed);
+            const std::uint32_t node = slots[i].node.load(std::memory_order_relaxed);
+            if (key != 0 && node < newIndex.size() && newIndex[node] != NodeArena::NO_NODE) kept.emplace_back(key, newIndex[node]);
+        }
+        clear();
+        for (const auto& [key, node] : kept) insert(key, node);
+    }
+
+    // ----- Engine -----
+
+    MctsEngine::MctsEngine() : evaluator(std::make_unique<HeuristicEvaluator>(&evalCache)) {
+        leafEvaluator = evaluator.get();
+        arena.reset(treeMB);
+    }
+
+    void MctsEngine::setEvaluator(std::unique_ptr<LeafEvaluator> newEvaluator) {
+        evaluator = std::move(newEvaluator);
+        leafEvaluator = evaluator.get();
+        clear();
+    }
+
+    void MctsEngine::clear() {
+        arena.clear();
+        table.clear();
+        root = NodeArena::NO_NODE;
+    }
+
+    std::size_t MctsEngine::distinctPositions() const {
+        std::unordered_set<std::uint64_t> keys;
+        for (std::size_t i = 0; i < arena.nodeCount(); ++i) keys.insert(arena.node(static_cast<std::uint32_t>(i)).key);
+        return keys.size();
+    }
+
+    Move MctsEngine::getBestMove(const Board& board, Color turnPlayer, const std::vector<Piece>& hand, const std::vector<Move>& validMoves) {
+        (void)hand; // Both hands are derived from the board by Position::fromBoard
+        if (validMoves.empty()) return PASS_MOVE;
+
+        const auto startTime = std::chrono::steady_clock::now();
+        const Position rootPos = Position::fromBoard(board, turnPlayer);
+
+        // The tables are mapped by the first search (see largepages.h)
+        if (arena.allocate() && verbose) std::cerr << PagesInfo("tree", treeMB, arena.backing()) << std::endl;
+        if (graph && table.allocate() && verbose) std::cerr << PagesInfo("graph", table.sizeMB(), table.backing()) << std::endl;
+        if (evalCache.allocate() && verbose) std::cerr << PagesInfo("evalcache", evalCache.sizeMB(), evalCache.backing()) << std::endl;
+
+        stats = MctsStats();
+        if (reuseTree) reroot(rootPos.key());
+        if (!reuseTree || (root != NodeArena::NO_NODE && !rootMatches(rootPos, validMoves))) clear();
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int i = 0; i < threadCount; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->pos = rootPos;
+        }
+
+        if (root == NodeArena::NO_NODE) {
+            clear();
+            root = arena.allocNode(rootPos.key());
+            if (graph) table.insert(GraphKey(rootPos), root);
+        }
+        if (arena.node(root).state.load(std::memory_order_relaxed) == NodeArena::Unexpanded) {
+            // A fresh root gets one edge per class of symmetric moves
+            const float value = expand(*workers[0], root, symmetry ? UniqueMoves(rootPos, validMoves) : validMoves);
+            NodeArena::Node& r = arena.node(root);
+            r.visits.store(1, std::memory_order_relaxed);
+            r.valueSum.store(value, std::memory_order_relaxed);
+        }
+        stats.reusedVisits = arena.node(root).visits.load(std::memory_order_relaxed);
+
+        // Batched search: the threads evaluate through the queue until the end of the search
+        std::unique_ptr<SequentialBatchEvaluator> batchEvaluator;
+        std::unique_ptr<EvalQueue> queue;
+        std::unique_ptr<QueuedEvaluator> queued;
+        if (batchSize > 1) {
+            batchEvaluator = std::make_unique<SequentialBatchEvaluator>(*evaluator);
+            queue = std::make_unique<EvalQueue>(*batchEvaluator, batchSize, std::chrono::microseconds(batchLatencyUs));
+            queued = std::make_unique<QueuedEvaluator>(*queue);
+            leafEvaluator = queued.get();
+        }
+
+        // Helpers first, then the main thread. The threads stop together when the tree is full,
+        // and start again once it has been compacted
+        playoutCount = 0;
+        // Depth means nothing to the MCTS: a search bounded by depth only gets the default move time,
+        // unless "MaxPlayouts" bounds it. An infinite one (pondering) runs until stop()
+        SearchLimits budget = limits;
+        if (budget.moveTime >= NO_TIME_LIMIT && budget.depth > 0 && maxPlayouts == 0) budget.moveTime = DEFAULT_MOVE_TIME;
+        TimeManager clock;
+        clock.start(budget);
+        const auto deadline = clock.hardDeadline();
+        while (true) {
+            recycleNeeded = false;
+            std::vector<std::thread> helpers;
+            for (int i = 1; i < threadCount; ++i) {
+                helpers.emplace_back([this, &workers, i, deadline] { run(*workers[i], deadline); });
+            }
+            run(*workers[0], deadline);
+            for (auto& t : helpers) t.join();
+
+            if (!recycleNeeded) break;
+            recycle();
+        }
+
+        if (queue) {
+            const EvalQueueStats q = queue->stats();
+            stats.batches = q.batches;
+            stats.averageBatch = q.averageBatch;
+            stats.averageLatencyUs = q.averageLatencyUs;
+            stats.evalsPerSecond = q.evalsPerSecond;
+            leafEvaluator = evaluator.get();
+        }
+
+        for (const auto& w : workers) {
+            stats.playouts += w->playouts;
+            stats.collisions += w->collisions;
+            stats.evaluations += w->evaluations;
+            stats.transpositions += w->transpositions;
+            stats.widenings += w->widenings;
+        }
+
+        const std::uint32_t best = bestEdge(root);
+        const NodeArena::Edge& e = arena.edge(best);
+        const Move move = UnpackMove(e.move);
+        const std::uint32_t bestChild = e.child.load(std::memory_order_relaxed);
+
+        stats.rootVisits = arena.node(root).visits.load(std::memory_order_relaxed);
+        stats.nodes = arena.nodeCount();
+        stats.edges = arena.edgeCount();
+        if (bestChild != NodeArena::NO_NODE && bestChild != NodeArena::CLAIMED) {
+            const NodeArena::Node& child = arena.node(bestChild);
+            const std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+            if (visits > 0) stats.value = -child.valueSum.load(std::memory_order_relaxed) / static_cast<float>(visits);
+        }
+        stats.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        stats.pv = principalVariation();
+
+        if (verbose) {
+            const auto ms = std::max<long long>(stats.time.count(), 1);
+            std::cerr << "info playouts " << stats.playouts << " reused " << stats.reusedVisits
+                      << " visits " << stats.rootVisits << " nodes " << stats.nodes << " recycled " << stats.recycled
+                      << " pps " << stats.playouts * 1000 / static_cast<std::uint64_t>(ms) << " time " << stats.time.count()
+                      << " collisions " << stats.collisions << " evals " << stats.evaluations
+                      << " evalhits " << evalCache.hitRate();
+            if (graph) std::cerr << " transpositions " << stats.transpositions;
+            if (widening) std::cerr << " edges " << stats.edges << " widenings " << stats.widenings;
+            if (stats.compactions > 0) std::cerr << " compactions " << stats.compactions;
+            if (stats.batches > 0) {
+                std::cerr << " batch " << stats.averageBatch << " latency " << static_cast<long long>(stats.averageLatencyUs)
+                          << " eps " << static_cast<long long>(stats.evalsPerSecond);
+            }
+            std::cerr << " value " << stats.value << " pv ";
+            Position p = rootPos;
+            for (size_t i = 0; i < stats.pv.size(); ++i) {
+                std::cerr << (i > 0 ? ";" : "") << MoveToString(stats.pv[i], p.board);
+                p.play(stats.pv[i]);
+            }
+            std::cerr << std::endl;
+        }
+
+        // The root stays the current position: the next search finds the new one below it
+        return move;
+    }
+
+    void MctsEngine::reroot(std::uint64_t key) {
+        if (root == NodeArena::NO_NODE) return;
+
+        // Breadth-first over the first two plies: same position, one move later (e.g. after a pass), two moves later
+        std::vector<std::uint32_t> frontier = {root};
+        std::uint32_t found = NodeArena::NO_NODE;
+        for (int ply = 0; ply <= 2 && found == NodeArena::NO_NODE; ++ply) {
+            std::vector<std::uint32_t> next;
+            for (std::uint32_t n : frontier) {
+                const NodeArena::Node& node = arena.node(n);
+                if (node.key == key) {
+                    found = n;
+                    break;
+                }
+                for (std::uint32_t i = 0; i < node.edgeCount; ++i) {
+                    const std::uint32_t child = arena.edge(node.firstEdge + i).child.load(std::memory_order_relaxed);
+                    if (child != NodeArena::NO_NODE && child != NodeArena::CLAIMED) next.push_back(child);
+                }
+            }
+            frontier.swap(next);
+        }
+
+        if (found == NodeArena::NO_NODE) {
+            clear();
+            return;
+        }
+        if (found == root) return;
+
+        std::vector<std::uint32_t> remap;
+        stats.recycled += arena.compact(found, 0, remap);
+        if (graph) table.remap(remap);
+        root = remap[found];
+    }
+
+    bool MctsEngine::rootMatches(const Position& rootPos, const std::vector<Move>& validMoves) const {
+        const NodeArena::Node& node = arena.node(root);
+        const std::uint8_t state = node.state.load(std::memory_order_relaxed);
+        if (state == NodeArena::Unexpanded || state == NodeArena::Terminal) return true;
+
+        std::unordered_set<std::uint32_t> legal;
+        for (const Move& m : validMoves) legal.insert(PackMove(m));
+        const std::uint32_t count = node.edgeCount.load(std::memory_order_relaxed);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (!legal.count(arena.edge(node.firstEdge + i).move)) return false;
+        }
+
+        // Every edge is legal. A Partial node opens the rest of its placements later; otherwise, the root of a
+        // previous search has one edge per class of symmetric moves
+        if (state != NodeArena::Expanded || count == validMoves.size()) return true;
+        return symmetry && count == UniqueMoves(rootPos, validMoves).size();
+    }
+
+    bool MctsEngine::treeFull() const {
+        return arena.nodeCount() * HIGH_WATER_DEN >= arena.maxNodes() * HIGH_WATER_NUM
+               || arena.edgeCount() * HIGH_WATER_DEN >= arena.maxEdges() * HIGH_WATER_NUM;
+    }
+
+    void MctsEngine::recycle() {
+        // The fewest visits worth keeping, doubled until the survivors fit. The root alone always does
+        std::uint32_t minVisits = 2;
+        while (true) {
+            const auto [nodes, edges] = arena.liveSize(root, minVisits);
+            if (nodes <= arena.maxNodes() / 2 && edges <= arena.maxEdges() / 2) break;
+            minVisits *= 2;
+        }
+
+        std::vector<std::uint32_t> remap;
+        stats.recycled += arena.compact(root, minVisits, remap);
+        if (graph) table.remap(remap);
+        root = remap[root];
+        ++stats.compactions;
+    }
+
+    void MctsEngine::run(Worker& w, std::chrono::steady_clock::time_point deadline) {
+        for (std::uint64_t i = 0;; ++i) {
+            if (maxPlayouts != 0 && playoutCount.load(std::memory_order_relaxed) >= maxPlayouts) break;
+            if (stopRequested.load(std::memory_order_relaxed)) break;
+            if (i % TIME_CHECK_PLAYOUTS == 0 && std::chrono::steady_clock::now() >= deadline) break;
+            if (recycleNeeded.load(std::memory_order_relaxed)) break;
+            if (treeFull()) {
+                recycleNeeded = true;
+                break;
+            }
+
+            if (playout(w)) {
+                ++w.playouts;
+                playoutCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                // The leaf is being expanded by another thread: let it finish
+                ++w.collisions;
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool MctsEngine::playout(Worker& w) {
+        Position& pos = w.pos;
+        std::vector<std::uint32_t>& path = w.path;
+        std::vector<std::uint32_t>& pathEdges = w.pathEdges;
+        path.clear();
+        pathEdges.clear();
+
+        // Nodes from the root to the leaf, each holding a virtual loss of this playout
+        path.push_back(root);
+        arena.node(root).virtualLoss.fetch_add(1, std::memory_order_relaxed);
+
+        std::uint32_t nodeIdx = root;
+        float value = 0.0f;
+        bool collision = false;
+        int played = 0;
+
+        while (true) {
+            NodeArena::Node& node = arena.node(nodeIdx);
+            const std::uint8_t state = node.state.load(std::memory_order_acquire);
+            if (state == NodeArena::Terminal) {
+                value = node.utility;
+                break;
+            }
+            if (state == NodeArena::Unexpanded) {
+                // The edge pool was full when the node was created: it stays a leaf
+                value = graph ? node.utility : expand(w, NodeArena::NO_NODE);
+                break;
+            }
+            if (state == NodeArena::Partial && openWidth(node.visits.load(std::memory_order_relaxed)) >= node.edgeCount) widen(w, nodeIdx);
+
+            const std::uint32_t edgeIdx = select(nodeIdx);
+            NodeArena::Edge& e = arena.edge(edgeIdx);
+            std::uint32_t child = e.child.load(std::memory_order_acquire);
+            if (child == NodeArena::CLAIMED) {
+                collision = true;
+                break;
+            }
+
+            pos.play(UnpackMove(e.move));
+            ++played;
+
+            if (child == NodeArena::NO_NODE) {
+                // Claim the edge: only the winner creates and expands the child
+                if (!e.child.compare_exchange_strong(child, NodeArena::CLAIMED, std::memory_order_acq_rel)) {
+                    if (child == NodeArena::CLAIMED) {
+                        collision = true;
+                        break;
+                    }
+                    // Created meanwhile by another thread: descend into it
+                } else if (graph && (child = table.find(GraphKey(pos))) != NodeArena::NO_NODE) {
+                    // Transposition: the edge joins the node of the position
+                    e.child.store(child, std::memory_order_release);
+                    ++w.transpositions;
+                } else {
+                    child = arena.allocNode(pos.key());
+                    if (child == NodeArena::NO_NODE) {
+                        // Node pool full: the position is evaluated but not kept
+                        value = -expand(w, NodeArena::NO_NODE);
+                        e.child.store(NodeArena::NO_NODE, std::memory_order_release);
+                        break;
+                    }
+                    arena.node(child).virtualLoss.store(1, std::memory_order_relaxed);
+                    pathEdges.push_back(edgeIdx);
+                    path.push_back(child);
+                    value = expand(w, child);
+                    if (graph) table.insert(GraphKey(pos), child);
+                    // Publish the child once expanded
+                    e.child.store(child, std::memory_order_release);
+                    break;
+                }
+            }
+
+            if (graph) {
+                pathEdges.push_back(edgeIdx);
+                // The child already knows more than the edge credits it with, or closes a cycle:
+                // the edge takes its value without descending
+                const bool cycle = std::find(path.begin(), path.end(), child) != path.end();
+                if (cycle || e.visits.load(std::memory_order_relaxed) < arena.node(child).visits.load(std::memory_order_relaxed)) break;
+            }
+
+            nodeIdx = child;
+            arena.node(nodeIdx).virtualLoss.fetch_add(1, std::memory_order_relaxed);
+            path.push_back(nodeIdx);
+        }
+
+        if (collision) {
+            for (std::uint32_t n : path) arena.node(n).virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+        } else if (graph) {
+            // Bottom-up: count the edge taken from each node, then recompute the node from its edges
+            for (std::size_t i = path.size(); i-- > 0;) {
+                if (i < pathEdges.size()) arena.edge(pathEdges[i]).visits.fetch_add(1, std::memory_order_relaxed);
+                refresh(path[i]);
+                arena.node(path[i]).virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+            }
+        } else {
+            // Backup, flipping the point of view at each ply
+            for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                backup(arena.node(*it), value);
+                value = -value;
+            }
+        }
+
+        while (played-- > 0) pos.undo();
+        return !collision;
+    }
+
+    void MctsEngine::backup(NodeArena::Node& node, float value) {
+        float sum = node.valueSum.load(std::memory_order_relaxed);
+        while (!node.valueSum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {}
+        node.visits.fetch_add(1, std::memory_order_relaxed);
+        node.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void MctsEngine::refresh(std::uint32_t nodeIdx) {
+        NodeArena::Node& node = arena.node(nodeIdx);
+        const std::uint32_t count = node.edgeCount.load(std::memory_order_acquire);
+        const std::uint32_t firstEdge = node.firstEdge.load(std::memory_order_relaxed);
+        float sum = node.utility;
+        std::uint32_t visits = 1;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const NodeArena::Edge& e = arena.edge(firstEdge + i);
+            const std::uint32_t n = e.visits.load(std::memory_order_relaxed);
+            const std::uint32_t child = e.child.load(std::memory_order_relaxed);
+            if (n == 0 || child == NodeArena::NO_NODE || child == NodeArena::CLAIMED) continue;
+
+            const NodeArena::Node& c = arena.node(child);
+            const std::uint32_t childVisits = c.visits.load(std::memory_order_relaxed);
+            if (childVisits == 0) continue;
+            sum -= static_cast<float>(n) * c.valueSum.load(std::memory_order_relaxed) / static_cast<float>(childVisits);
+            visits += n;
+        }
+        // Concurrent refreshes of a node may interleave: the last one wins, from equally recent edges
+        node.valueSum.store(sum, std::memory_order_relaxed);
+        node.visits.store(visits, std::memory_order_relaxed);
+    }
+
+    float MctsEngine::expand(Worker& w, std::uint32_t nodeIdx, const std::vector<Move>& rootMoves) {
+        const Position& pos = w.pos;
+
+        // Terminal positions: a surrounded Queen ends the game
+        const bool ownSurrounded = pos.isQueenSurrounded(pos.turnPlayer);
+        const bool rivalSurrounded = pos.isQueenSurrounded(rival(pos.turnPlayer));
+        if (ownSurrounded || rivalSurrounded) {
+            const float value = (ownSurrounded && rivalSurrounded) ? 0.0f : (ownSurrounded ? -1.0f : 1.0f);
+            if (nodeIdx != NodeArena::NO_NODE) {
+                NodeArena::Node& node = arena.node(nodeIdx);
+                node.utility = value;
+                node.state.store(NodeArena::Terminal, std::memory_order_release);
+            }
+            return value;
+        }
+
+        // With widening, a leaf (not the root) starts with its piece moves and the first batch of placements
+        bool partial = false;
+        if (widening && rootMoves.empty() && nodeIdx != NodeArena::NO_NODE) {
+            w.moves = pos.generatePieceMoves();
+            w.placements = pos.generatePlacements();
+            SortPlacements(pos, w.placements);
+            partial = w.placements.size() > PLACEMENT_BATCH;
+            w.moves.insert(w.moves.end(), w.placements.begin(), w.placements.begin() + static_cast<std::ptrdiff_t>(std::min(w.placements.size(), PLACEMENT_BATCH)));
+        } else {
+            w.moves = rootMoves.empty() ? pos.generateMoves() : rootMoves;
+        }
+        if (w.moves.empty()) w.moves.push_back(PASS_MOVE);
+        const float value = leafEvaluator->evaluate(pos, w.moves, w.priors);
+        ++w.evaluations;
+        if (nodeIdx == NodeArena::NO_NODE) return value;
+        arena.node(nodeIdx).utility = value;
+
+        const auto count = static_cast<std::uint32_t>(w.moves.size());
+        const std::uint32_t first = arena.allocEdges(count);
+        if (first == NodeArena::NO_NODE) return value;  // Edge pool full: the node stays a leaf
+
+        // Widening opens the edges in order: best priors first
+        w.order.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i) w.order[i] = i;
+        if (widening) {
+            std::stable_sort(w.order.begin(), w.order.end(), [&](std::uint32_t a, std::uint32_t b) { return w.priors[a] > w.priors[b]; });
+        }
+        for (std::uint32_t i = 0; i < count; ++i) {
+            NodeArena::Edge& e = arena.edge(first + i);
+            e.move = PackMove(w.moves[w.order[i]]);
+            e.prior = w.priors[w.order[i]];
+            e.child.store(NodeArena::NO_NODE, std::memory_order_relaxed);
+            e.visits.store(0, std::memory_order_relaxed);
+        }
+        NodeArena::Node& node = arena.node(nodeIdx);
+        node.firstEdge.store(first, std::memory_order_relaxed);
+        node.edgeCount.store(static_cast<std::uint16_t>(count), std::memory_order_release);
+        node.state.store(partial ? NodeArena::Partial : NodeArena::Expanded, std::memory_order_release);
+        return value;
+    }
+
+    std::uint32_t MctsEngine::openWidth(std::uint32_t visits) {
+        return static_cast<std::uint32_t>(WIDENING_BASE + WIDENING_FACTOR * std::sqrt(static_cast<float>(visits)));
+    }
+
+    void MctsEngine::widen(Worker& w, std::uint32_t nodeIdx) {
+        NodeArena::Node& node = arena.node(nodeIdx);
+        std::uint8_t expected = NodeArena::Partial;
+        if (!node.state.compare_exchange_strong(expected, NodeArena::Widening, std::memory_order_acq_rel)) return;
+
+        const std::uint32_t oldCount = node.edgeCount.load(std::memory_order_relaxed);
+        const std::uint32_t oldFirst = node.firstEdge.load(std::memory_order_relaxed);
+
+        // The placements are generated again in the same order: the first ones are the edges already there
+        std::size_t opened = 0;
+        float lowestPrior = 1.0f;
+        for (std::uint32_t i = 0; i < oldCount; ++i) {
+            const NodeArena::Edge& e = arena.edge(oldFirst + i);
+            if (UnpackMove(e.move).type == Move::Place) ++opened;
+            lowestPrior = std::min(lowestPrior, e.prior);
+        }
+        w.placements = w.pos.generatePlacements();
+        SortPlacements(w.pos, w.placements);
+        const std::size_t added = std::min(w.placements.size() - std::min(opened, w.placements.size()), std::max(opened, PLACEMENT_BATCH));
+        const bool more = opened + added < w.placements.size();
+
+        const auto count = static_cast<std::uint32_t>(oldCount + added);
+        const std::uint32_t first = arena.allocEdges(count);
+        if (first == NodeArena::NO_NODE) {
+            // Edge pool full: the node keeps its edges
+            node.state.store(NodeArena::Expanded, std::memory_order_release);
+            return;
+        }
+
+        // Seal the old edges, so that no thread still reading the old range links a child to them
+        for (std::uint32_t i = 0; i < oldCount; ++i) {
+            NodeArena::Edge& from = arena.edge(oldFirst + i);
+            NodeArena::Edge& to = arena.edge(first + i);
+            std::uint32_t child = from.child.load(std::memory_order_acquire);
+            while (true) {
+                if (child == NodeArena::CLAIMED) {
+                    // Child being created: wait for it
+                    std::this_thread::yield();
+                    child = from.child.load(std::memory_order_acquire);
+                } else if (from.child.compare_exchange_weak(child, NodeArena::CLAIMED, std::memory_order_acq_rel)) {
+                    break;
+                }
+            }
+            to.move = from.move;
+            to.prior = from.prior;
+            to.child.store(child, std::memory_order_relaxed);
+            to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        // The new placements rank after the opened edges, without an evaluation of their own
+        for (std::uint32_t i = oldCount; i < count; ++i) {
+            NodeArena::Edge& e = arena.edge(first + i);
+            e.move = PackMove(w.placements[opened + (i - oldCount)]);
+            e.prior = lowestPrior;
+            e.child.store(NodeArena::NO_NODE, std::memory_order_relaxed);
+            e.visits.store(0, std::memory_order_relaxed);
+        }
+
+        node.firstEdge.store(first, std::memory_order_relaxed);
+        node.edgeCount.store(static_cast<std::uint16_t>(count), std::memory_order_release);
+        node.state.store(more ? NodeArena::Partial : NodeArena::Expanded, std::memory_order_release);
+        ++w.widenings;
+    }
+
+    std::uint32_t MctsEngine::select(std::uint32_t nodeIdx) {
+        const NodeArena::Node& node = arena.node(nodeIdx);
+        const std::uint32_t parentVisits = node.visits.load(std::memory_order_relaxed);
+        const std::uint32_t parentN = parentVisits + node.virtualLoss.load(std::memory_order_relaxed);
+        const float parentQ = node.valueSum.load(std::memory_order_relaxed) / static_cast<float>(std::max<std::uint32_t>(parentVisits, 1));
+        const float explore = cpuct * std::sqrt(static_cast<float>(parentN));
+
+        std::uint32_t count = node.edgeCount.load(std::memory_order_acquire);
+        const std::uint32_t firstEdge = node.firstEdge.load(std::memory_order_relaxed);
+        if (widening) count = std::min(count, openWidth(parentVisits));
+
+        std::uint32_t best = firstEdge;
+        float bestScore = -1e9f;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const NodeArena::Edge& e = arena.edge(firstEdge + i);
+            const std::uint32_t child = e.child.load(std::memory_order_relaxed);
+
+            float q = parentQ - FPU_REDUCTION;
+            std::uint32_t n = 0;
+            if (child == NodeArena::CLAIMED) {
+                // Being expanded: counts as one lost visit
+                q = -1.0f;
+                n = 1;
+            } else if (child != NodeArena::NO_NODE) {
+                const NodeArena::Node& c = arena.node(child);
+                const std::uint32_t vl = c.virtualLoss.load(std::memory_order_relaxed);
+                const std::uint32_t childVisits = c.visits.load(std::memory_order_relaxed);
+                if (graph) {
+                    // The child value may have been learned through other parents: weighted by the edge visits
+                    const std::uint32_t edgeN = e.visits.load(std::memory_order_relaxed);
+                    n = edgeN + vl;
+                    if (childVisits > 0) {
+                        const float childQ = -c.valueSum.load(std::memory_order_relaxed) / static_cast<float>(childVisits);
+                        q = n > 0 ? (childQ * static_cast<float>(edgeN) - static_cast<float>(vl)) / static_cast<float>(n) : childQ;
+                    }
+                } else {
+                    n = childVisits + vl;
+                    // Each virtual loss counts as a lost playout for the player choosing the edge
+                    if (n > 0) q = (-c.valueSum.load(std::memory_order_relaxed) - static_cast<float>(vl)) / static_cast<float>(n);
+                }
+            }
+
+            const float score = q + explore * e.prior / static_cast<float>(1 + n);
+            if (score > bestScore) {
+                bestScore = score;
+                best = firstEdge + i;
+            }
+        }
+        return best;
+    }
+
+    std::uint32_t MctsEngine::bestEdge(std::uint32_t nodeIdx) {
+        const NodeArena::Node& node = arena.node(nodeIdx);
+        const std::uint32_t count = node.edgeCount.load(std::memory_order_acquire);
+        const std::uint32_t firstEdge = node.firstEdge.load(std::memory_order_relaxed);
+        std::uint32_t best = firstEdge;
+        std::uint32_t bestVisits = 0;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const std::uint32_t visits = edgeVisits(arena.edge(firstEdge + i));
+            if (visits > bestVisits) {
+                bestVisits = visits;
+                best = firstEdge + i;
+            }
+        }
+        return best;
+    }
+
+    std::uint32_t MctsEngine::edgeVisits(const NodeArena::Edge& e) {
+        if (graph) return e.visits.load(std::memory_order_relaxed);
+        const std::uint32_t child = e.child.load(std::memory_order_relaxed);
+        if (child == NodeArena::NO_NODE || child == NodeArena::CLAIMED) return 0;
+        return arena.node(child).visits.load(std::memory_order_relaxed);
+    }
+
+    std::vector<Move> MctsEngine::principalVariation() {
+        std::vector<Move> pv;
+        std::uint32_t nodeIdx = root;
+        while (nodeIdx != NodeArena::NO_NODE && static_cast<int>(pv.size()) < MAX_PV) {
+            const NodeArena::Node& node = arena.node(nodeIdx);
+            if (node.edgeCount == 0) break;
+            const NodeArena::Edge& e = arena.edge(bestEdge(nodeIdx));
+            const std::uint32_t child = e.child.load(std::memory_order_relaxed);
+            if (child == NodeArena::NO_NODE || child == NodeArena::CLAIMED) break;
+            pv.push_back(UnpackMove(e.move));
+            nodeIdx = child;
+        }
+        return pv;
+    }
+
+    std::vector<EngineOption> MctsEngine::getOptions() const {
+        return {
+            {"Cpuct", "double", std::to_string(cpuct), "1.5", {"0.1", "10"}},
+            {"Threads", "int", std::to_string(threadCount), "1", {"1", std::to_string(MAX_THREADS)}},
+            {"BatchSize", "int", std::to_string(batchSize), "1", {"1", std::to_string(MAX_THREADS)}},
+            {"BatchLatencyUs", "int", std::to_string(batchLatencyUs), "1000", {"10", "1000000"}},
+            {"TreeSizeMB", "int", std::to_string(treeMB), std::to_string(DEFAULT_TREE_MB), {"16", "65536"}},
+            {"EvalCacheMB", "int", std::to_string(evalCache.sizeMB()), std::to_string(EvalCache::DEFAULT_SIZE_MB), {"0", "4096"}},
+            {"MaxPlayouts", "int", std::to_string(maxPlayouts), "0", {"0", "100000000"}},
+            {"ReuseTree", "bool", reuseTree ? "True" : "False", "True", {}},
+            {"GraphSearch", "bool", graph ? "True" : "False", "False", {}},
+            {"Widening", "bool", widening ? "True" : "False", "False", {}},
+            {"Symmetry", "bool", symmetry ? "True" : "False", "True", {}}
+        };
+    }
+
+    bool MctsEngine::setOption(const std::string& name, const std::string& value) {
+        try {
+            if (name == "Cpuct") {
+                const float c = std::stof(value);
+                if (c < 0.1f || c > 10.0f) return false;
+                cpuct = c;
+                return true;
+            }
+            if (name == "Threads") {
+                const int threads = std::stoi(value);
+                if (threads < 1 || threads > MAX_THREADS) return false;
+                threadCount = threads;
+                return true;
+            }
+            if (name == "BatchSize") {
+                const int size = std::stoi(value);
+                if (size < 1 || size > MAX_THREADS) return false;
+                batchSize = size;
+                return true;
+            }
+            if (name == "BatchLatencyUs") {
+                const int us = std::stoi(value);
+                if (us < 10 || us > 1000000) return false;
+                batchLatencyUs = us;
+                return true;
+            }
+            if (name == "TreeSizeMB") {
+                const int mb = std::stoi(value);
+                if (mb < 16 || mb > 65536) return false;
+                treeMB = static_cast<std::size_t>(mb);
+                arena.reset(treeMB);
+                if (graph) table.reset(arena.maxNodes() * TABLE_SLOTS_PER_NODE);
+                root = NodeArena::NO_NODE;
+                return true;
+            }
+            if (name == "EvalCacheMB") {
+                const int mb = std::stoi(value);
+                if (mb < 0 || mb > 4096) return false;
+                evalCache.resize(static_cast<std::size_t>(mb));
+                return true;
+            }
+            if (name == "MaxPlayouts") {
+                const long long n = std::stoll(value);
+                if (n < 0 || n > 100000000) return false;
+                maxPlayouts = static_cast<std::uint64_t>(n);
+                return true;
+            }
+            if (name == "ReuseTree") {
+                if (value != "True" && value != "False") return false;
+                reuseTree = (value == "True");
+                return true;
+            }
+            if (name == "Symmetry") {
+                if (value != "True" && value != "False") return false;
+                symmetry = (value == "True");
+                return true;
+            }
+            if (name == "Widening") {
+                if (value != "True" && value != "False") return false;
+                const bool enabled = (value == "True");
+                if (enabled == widening) return true;
+                // The edges of a widened tree are sorted and partial: start over
+                widening = enabled;
+                clear();
+                return true;
+            }
+            if (name == "GraphSearch") {
+                if (value != "True" && value != "False") return false;
+                const bool enabled = (value == "True");
+                if (enabled == graph) return true;
+                // Tree and graph statistics differ: start over
+                graph = enabled;
+                if (graph && table.empty()) table.reset(arena.maxNodes() * TABLE_SLOTS_PER_NODE);
+                clear();
+                return true;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return false;
+    }
+
+}
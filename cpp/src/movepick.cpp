@@ -0,0 +1,107 @@
+#include "headers/movepick.h"
+
+#include <algorithm>
+
+namespace Hive {
+
+    namespace {
+        // Ordering score bands, from the highest
+        constexpr int HASH_SCORE = 1 << 30;
+        constexpr int QUEEN_MOVE_SCORE = 1 << 29;
+        constexpr int KILLER_SCORE = 1 << 28;
+        constexpr int COUNTER_SCORE = 1 << 27;
+    }
+
+    void OrderingTables::clear() {
+        for (auto& k : killers) k.fill(0);
+        for (auto& h : history) h.fill(0);
+        for (auto& c : countermoves) c.fill(0);
+    }
+
+    void OrderingTables::updateHistory(const Move& move, int bonus) {
+        // Gravity: the closer to HISTORY_MAX, the smaller the change, so scores stay bounded
+        int& entry = history[pieceIndex(move.piece)][Board::AxToIndex(move.to)];
+        entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+    }
+
+    void OrderingTables::update(const Position& pos, const Move& cutMove, const std::vector<Move>& triedQuiets, int depth, int ply) {
+        const std::uint32_t packed = PackMove(cutMove);
+        if (killers[ply][0] != packed) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = packed;
+        }
+
+        const int bonus = std::min(depth * depth, HISTORY_MAX / 4);
+        updateHistory(cutMove, bonus);
+        for (const Move& m : triedQuiets) {
+            if (m != cutMove) updateHistory(m, -bonus);
+        }
+
+        const Move* previous = pos.lastMove();
+        if (previous && previous->type != Move::Pass) {
+            countermoves[pieceIndex(previous->piece)][Board::AxToIndex(previous->to)] = packed;
+        }
+    }
+
+    std::uint32_t OrderingTables::counterMove(const Position& pos) const {
+        const Move* previous = pos.lastMove();
+        if (!previous || previous->type == Move::Pass) return 0;
+        return countermoves[pieceIndex(previous->piece)][Board::AxToIndex(previous->to)];
+    }
+
+    bool isQueenMove(const Board& board, const Move& move) {
+        if (move.type == Move::Pass) return false;
+        if (move.piece.bug == Bug::Queen && move.type == Move::PieceMove) return true;
+
+        for (Color c : {Color::White, Color::Black}) {
+            Coord queen;
+            if (!board.locate({c, Bug::Queen, 0}, queen)) continue;
+            if (hexDistance(move.to, queen) <= 1) return true;
+            if (move.type == Move::PieceMove && hexDistance(move.from, queen) <= 1) return true;
+        }
+        return false;
+    }
+
+    MovePicker::MovePicker(const Position& pos, std::vector<Move>& moves, std::uint32_t hashMove,
+                           const OrderingTables* tables, int ply)
+        : moves(moves), scores(moves.size()), quiets(moves.size()) {
+        const std::uint32_t counter = tables ? tables->counterMove(pos) : 0;
+
+        for (size_t i = 0; i < moves.size(); ++i) {
+            const Move& m = moves[i];
+            const std::uint32_t packed = PackMove(m);
+            const bool queenMove = isQueenMove(pos.board, m);
+            const int history = (tables && m.type != Move::Pass) ? tables->historyScore(m) : 0;
+            quiets[i] = !queenMove;
+
+            if (hashMove != 0 && packed == hashMove) scores[i] = HASH_SCORE;
+            else if (queenMove) scores[i] = QUEEN_MOVE_SCORE + history;
+            else if (tables && tables->isKiller(m, ply)) scores[i] = KILLER_SCORE;
+            else if (counter != 0 && packed == counter) scores[i] = COUNTER_SCORE;
+            else scores[i] = history;
+        }
+    }
+
+    bool MovePicker::next(Move& out, bool& quiet) {
+        if (current >= moves.size()) return false;
+
+        // Selection step: bring the best remaining move to the current slot
+        size_t best = current;
+        for (size_t i = current + 1; i < moves.size(); ++i) {
+            if (scores[i] > scores[best]) best = i;
+        }
+        if (best != current) {
+            std::swap(moves[best], moves[current]);
+            std::swap(scores[best], scores[current]);
+            const bool q = quiets[best];
+            quiets[best] = quiets[current];
+            quiets[current] = q;
+        }
+
+        out = moves[current];
+        quiet = quiets[current];
+        ++current;
+        return true;
+    }
+
+}
@@ -1,4 +1,5 @@
 #include "headers/moves.h"
+#include "headers/rules.h"
 #include <unordered_set>
 #include <deque>
 #include <algorithm>
@@ -42,7 +43,8 @@ namespace Hive::Moves {
 
             for (const auto& n : neighbors) {
                 if (board.empty(n) && visited.find(n) == visited.end()) {
-                    if (RuleEngine::canSlide(board, currIdx, Board::AxToIndex(n)) && touchesHive(board, n, curr)) {
+                    // The origin is vacated while the Ant walks: cells touching only the origin are not valid
+                    if (RuleEngine::canSlide(board, currIdx, Board::AxToIndex(n)) && touchesHive(board, n, prop)) {
                         visited.insert(n);
                         queue.push_back(n);
                     }
@@ -61,7 +63,8 @@ namespace Hive::Moves {
 
             // The 3D slide rule natively handles climbing up, moving on top, and stepping down.
             if (RuleEngine::canSlide(board, propIdx, nIdx)) {
-                if (touchesHive(board, n, prop)) {
+                // Climbing on top of a piece always keeps contact with the hive
+                if (!board.empty(n) || touchesHive(board, n, prop)) {
                     targets.push_back(n);
                 }
             }
@@ -92,7 +95,7 @@ namespace Hive::Moves {
         std::vector<Coord> step2;
         for (const auto& s1 : step1) {
             for (const auto& n : coordNeighbors(s1)) {
-                if (!board.empty(n)) step2.push_back(n);
+                if (!board.empty(n) && n != prop) step2.push_back(n);
             }
         }
 
@@ -105,7 +108,7 @@ namespace Hive::Moves {
             }
         }
 
-        targets.assign(uniqueTargets.begin(), uniqueTargets.end());
+        targets.insert(targets.end(), uniqueTargets.begin(), uniqueTargets.end());
     }
 
 
@@ -217,7 +220,7 @@ namespace Hive::Moves {
                 if(visited) continue;
 
                 if (!RuleEngine::canSlide(board, currIdx, Board::AxToIndex(n))) continue;
-                if (!touchesHive(board, n, current.c)) continue;
+                if (!touchesHive(board, n, prop)) continue;
 
                 std::vector<Coord> nextPath = current.path;
                 nextPath.push_back(n);
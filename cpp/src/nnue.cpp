@@ -0,0 +1,285 @@
+#include "headers/nnue.h"
+#include "headers/board.h"
+#include "headers/position.h"
+#include "headers/zobrist.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Hive {
+
+    namespace {
+        constexpr int WEIGHT_SHIFT = 6;         // Dense layer weights are fixed point with 6 fractional bits
+        constexpr int ACTIVATION_MAX = 127;     // Clipped ReLU: 1.0 is 127
+        constexpr int OUTPUT_DIVISOR = 16;      // Output sum to centi-pieces
+
+        constexpr char MAGIC[4] = {'H', 'H', 'N', 'N'};
+
+        std::unique_ptr<Network> activeNetwork;
+        std::uint32_t generation = 0;
+
+        // ----- Kernels -----
+
+        void addColumn(std::int16_t* acc, const std::int16_t* column) {
+#if defined(__AVX2__)
+            for (int i = 0; i < NNUE_L1; i += 16) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, c));
+            }
+#else
+            for (int i = 0; i < NNUE_L1; ++i) acc[i] = static_cast<std::int16_t>(acc[i] + column[i]);
+#endif
+        }
+
+        void subColumn(std::int16_t* acc, const std::int16_t* column) {
+#if defined(__AVX2__)
+            for (int i = 0; i < NNUE_L1; i += 16) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, c));
+            }
+#else
+            for (int i = 0; i < NNUE_L1; ++i) acc[i] = static_cast<std::int16_t>(acc[i] - column[i]);
+#endif
+        }
+
+        // out = clip((bias + weights * in) >> WEIGHT_SHIFT), in of inSize activations (a multiple of 32)
+        void dense(const std::uint8_t* in, int inSize, const std::int8_t* weights, const std::int32_t* bias,
+                   int outSize, std::uint8_t* out) {
+            for (int o = 0; o < outSize; ++o) {
+                const std::int8_t* row = weights + static_cast<std::ptrdiff_t>(o) * inSize;
+                std::int32_t sum = bias[o];
+#if defined(__AVX2__)
+                // u8 x i8 pairs summed to i16 (no saturation: activations are at most 127), then to i32
+                const __m256i ones = _mm256_set1_epi16(1);
+                __m256i acc = _mm256_setzero_si256();
+                for (int i = 0; i < inSize; i += 32) {
+                    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                    const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+                    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+                }
+                __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+                s = _mm_hadd_epi32(s, s);
+                s = _mm_hadd_epi32(s, s);
+                sum += _mm_cvtsi128_si32(s);
+#else
+                for (int i = 0; i < inSize; ++i) sum += static_cast<std::int32_t>(in[i]) * row[i];
+#endif
+                out[o] = static_cast<std::uint8_t>(std::clamp(sum >> WEIGHT_SHIFT, 0, ACTIVATION_MAX));
+            }
+        }
+
+        // ----- Weights File -----
+
+        template <typename T>
+        void readArray(std::istream& in, T* values, std::size_t count) {
+            std::vector<unsigned char> bytes(count * sizeof(T));
+            if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+                throw std::invalid_argument("Truncated network file");
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                std::uint64_t v = 0;
+                for (std::size_t b = 0; b < sizeof(T); ++b) v |= static_cast<std::uint64_t>(bytes[i * sizeof(T) + b]) << (8 * b);
+                values[i] = static_cast<T>(v);
+            }
+        }
+
+        template <typename T>
+        void writeArray(std::ostream& out, const T* values, std::size_t count) {
+            std::vector<unsigned char> bytes(count * sizeof(T));
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto v = static_cast<std::uint64_t>(values[i]);
+                for (std::size_t b = 0; b < sizeof(T); ++b) bytes[i * sizeof(T) + b] = static_cast<unsigned char>(v >> (8 * b));
+            }
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+    }
+
+    int NnueFeature(Color perspective, const Piece& piece, Coord cell, int level, const Coord* anchor) {
+        int slot = pieceIndex(piece);
+        if (perspective == Color::Black) slot = (slot + PIECES_PER_COLOR) % PIECE_COUNT;
+
+        int bucket = NNUE_CELLS - 1;
+        if (anchor != nullptr) {
+            const int dq = cell.q - anchor->q;
+            const int dr = cell.r - anchor->r;
+            if (std::abs(dq) <= NNUE_RADIUS && std::abs(dr) <= NNUE_RADIUS) {
+                bucket = (dq + NNUE_RADIUS) * NNUE_SIDE + (dr + NNUE_RADIUS);
+            }
+        }
+        return (slot * NNUE_CELLS + bucket) * NNUE_LEVELS + std::min(level, NNUE_LEVELS - 1);
+    }
+
+    // ----- Network -----
+
+    Network::Network()
+        : featureBias(new std::int16_t[NNUE_L1]()),
+          featureWeights(new std::int16_t[static_cast<std::size_t>(NNUE_FEATURES) * NNUE_L1]()),
+          l2Bias(new std::int32_t[NNUE_L2]()),
+          l2Weights(new std::int8_t[NNUE_L2 * 2 * NNUE_L1]()),
+          l3Bias(new std::int32_t[NNUE_L3]()),
+          l3Weights(new std::int8_t[NNUE_L3 * NNUE_L2]()),
+          outWeights(new std::int8_t[NNUE_L3]()) {}
+
+    void Network::update(NnueAccumulator& acc, Color perspective, int feature, int sign) const {
+        const std::int16_t* column = featureWeights.get() + static_cast<std::ptrdiff_t>(feature) * NNUE_L1;
+        std::int16_t* values = acc.values[static_cast<int>(perspective)].data();
+        if (sign > 0) addColumn(values, column);
+        else subColumn(values, column);
+    }
+
+    void Network::refresh(const Board& board, NnueAccumulator& acc, Color perspective) const {
+        auto& values = acc.values[static_cast<int>(perspective)];
+        std::copy(featureBias.get(), featureBias.get() + NNUE_L1, values.begin());
+
+        Coord anchor;
+        const bool placed = board.locate({perspective, Bug::Queen, 0}, anchor);
+        for (const Coord& c : board.occupiedCoords()) {
+            const Board::Cell& cell = board.cell(c);
+            for (int level = 0; level < cell.size(); ++level) {
+                update(acc, perspective, NnueFeature(perspective, cell._data[level], c, level, placed ? &anchor : nullptr), 1);
+            }
+        }
+    }
+
+    NnueAccumulator Network::compute(const Board& board) const {
+        NnueAccumulator acc;
+        refresh(board, acc, Color::White);
+        refresh(board, acc, Color::Black);
+        acc.generation = generation;
+        return acc;
+    }
+
+    int Network::forward(const NnueAccumulator& acc, Color turnPlayer) const {
+        alignas(32) std::uint8_t input[2 * NNUE_L1];
+        alignas(32) std::uint8_t hidden2[NNUE_L2];
+        alignas(32) std::uint8_t hidden3[NNUE_L3];
+
+        const Color order[2] = {turnPlayer, rival(turnPlayer)};
+        for (int h = 0; h < 2; ++h) {
+            const auto& values = acc.values[static_cast<int>(order[h])];
+            for (int i = 0; i < NNUE_L1; ++i) {
+                input[h * NNUE_L1 + i] = static_cast<std::uint8_t>(std::clamp<int>(values[i], 0, ACTIVATION_MAX));
+            }
+        }
+
+        dense(input, 2 * NNUE_L1, l2Weights.get(), l2Bias.get(), NNUE_L2, hidden2);
+        dense(hidden2, NNUE_L2, l3Weights.get(), l3Bias.get(), NNUE_L3, hidden3);
+
+        std::int32_t out = outBias;
+        for (int i = 0; i < NNUE_L3; ++i) out += static_cast<std::int32_t>(hidden3[i]) * outWeights[i];
+        return out / OUTPUT_DIVISOR;
+    }
+
+    std::unique_ptr<Network> Network::load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::invalid_argument("Cannot read network file: " + path);
+
+        char magic[4];
+        if (!in.read(magic, 4) || !std::equal(magic, magic + 4, MAGIC)) throw std::invalid_argument("Not a network file: " + path);
+
+        std::uint32_t header[5];
+        readArray(in, header, 5);
+        if (header[0] != NNUE_VERSION) throw std::invalid_argument("Unsupported network version " + std::to_string(header[0]));
+        if (header[1] != static_cast<std::uint32_t>(NNUE_FEATURES) || header[2] != static_cast<std::uint32_t>(NNUE_L1) ||
+            header[3] != static_cast<std::uint32_t>(NNUE_L2) || header[4] != static_cast<std::uint32_t>(NNUE_L3)) {
+            throw std::invalid_argument("Network dimensions do not match this build");
+        }
+
+        auto network = std::make_unique<Network>();
+        readArray(in, network->featureBias.get(), NNUE_L1);
+        readArray(in, network->featureWeights.get(), static_cast<std::size_t>(NNUE_FEATURES) * NNUE_L1);
+        readArray(in, network->l2Bias.get(), NNUE_L2);
+        readArray(in, network->l2Weights.get(), NNUE_L2 * 2 * NNUE_L1);
+        readArray(in, network->l3Bias.get(), NNUE_L3);
+        readArray(in, network->l3Weights.get(), NNUE_L3 * NNUE_L2);
+        readArray(in, &network->outBias, 1);
+        readArray(in, network->outWeights.get(), NNUE_L3);
+        return network;
+    }
+
+    void Network::save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) throw std::invalid_argument("Cannot write network file: " + path);
+
+        out.write(MAGIC, 4);
+        const std::uint32_t header[5] = {NNUE_VERSION, NNUE_FEATURES, NNUE_L1, NNUE_L2, NNUE_L3};
+        writeArray(out, header, 5);
+        writeArray(out, featureBias.get(), NNUE_L1);
+        writeArray(out, featureWeights.get(), static_cast<std::size_t>(NNUE_FEATURES) * NNUE_L1);
+        writeArray(out, l2Bias.get(), NNUE_L2);
+        writeArray(out, l2Weights.get(), NNUE_L2 * 2 * NNUE_L1);
+        writeArray(out, l3Bias.get(), NNUE_L3);
+        writeArray(out, l3Weights.get(), NNUE_L3 * NNUE_L2);
+        writeArray(out, &outBias, 1);
+        writeArray(out, outWeights.get(), NNUE_L3);
+    }
+
+    std::unique_ptr<Network> Network::random(std::uint64_t seed) {
+        auto network = std::make_unique<Network>();
+        // Uniform in [-range, range]
+        std::uint64_t counter = seed << 32;
+        auto next = [&counter](int range) {
+            return static_cast<int>(splitmix64(counter++) % static_cast<std::uint64_t>(2 * range + 1)) - range;
+        };
+
+        for (int i = 0; i < NNUE_L1; ++i) network->featureBias[i] = static_cast<std::int16_t>(32 + next(16));
+        for (std::size_t i = 0; i < static_cast<std::size_t>(NNUE_FEATURES) * NNUE_L1; ++i) {
+            network->featureWeights[i] = static_cast<std::int16_t>(next(8));
+        }
+        for (int i = 0; i < NNUE_L2 * 2 * NNUE_L1; ++i) network->l2Weights[i] = static_cast<std::int8_t>(next(8));
+        for (int i = 0; i < NNUE_L3 * NNUE_L2; ++i) network->l3Weights[i] = static_cast<std::int8_t>(next(32));
+        for (int i = 0; i < NNUE_L2; ++i) network->l2Bias[i] = next(1024);
+        for (int i = 0; i < NNUE_L3; ++i) network->l3Bias[i] = next(1024);
+        for (int i = 0; i < NNUE_L3; ++i) network->outWeights[i] = static_cast<std::int8_t>(next(64));
+        return network;
+    }
+
+    // ----- Active Network -----
+
+    const Network* ActiveNetwork() {
+        return activeNetwork.get();
+    }
+
+    std::uint32_t NetworkGeneration() {
+        return generation;
+    }
+
+    std::unique_ptr<Network> SetNetwork(std::unique_ptr<Network> network) {
+        std::swap(activeNetwork, network);
+        // 0 marks accumulators never computed
+        if (++generation == 0) ++generation;
+        return network;
+    }
+
+    int NnueEvaluate(const Position& pos) {
+        const Network* network = ActiveNetwork();
+        assert(network != nullptr && "No active network");
+
+        const NnueAccumulator& acc = pos.board.accumulator();
+        // A board built before the network was loaded and not updated since
+        if (acc.generation != generation) return network->forward(network->compute(pos.board), pos.turnPlayer);
+
+#ifdef HIGH_HIVE_VERIFY_EVAL
+        assert(acc.values == network->compute(pos.board).values && "Network accumulator out of sync with the board");
+#endif
+        return network->forward(acc, pos.turnPlayer);
+    }
+
+    const char* NnueKernels() {
+#if defined(__AVX2__)
+        return "avx2";
+#else
+        return "scalar";
+#endif
+    }
+
+}
@@ -0,0 +1,547 @@
+#include "headers/position.h"
+#include "headers/utils.h"
+#include "headers/rules.h"
+
+#include <stdexcept>
+#include <sstream>
+#include <climits>
+
+namespace Hive {
+
+    namespace {
+        constexpr std::string_view BUG_LETTERS = "QBSGALMP";
+
+        // Parses the piece starting at str[pos] (bug letter and optional id) and advances pos
+        Piece parsePiece(const std::string& str, size_t& pos, Color color) {
+            if (pos >= str.size() || BUG_LETTERS.find(str[pos]) == std::string_view::npos) {
+                throw std::invalid_argument("Invalid piece in position: " + str);
+            }
+            std::string pieceStr = (color == Color::White) ? "w" : "b";
+            pieceStr += str[pos++];
+            if (pos < str.size() && str[pos] >= '1' && str[pos] <= '3') {
+                pieceStr += str[pos++];
+            }
+            return StringToPiece(pieceStr);
+        }
+
+        // Parses a colored piece ("wA1") starting at str[pos] and advances pos
+        Piece parseColoredPiece(const std::string& str, size_t& pos) {
+            if (pos >= str.size() || (str[pos] != 'w' && str[pos] != 'b')) {
+                throw std::invalid_argument("Invalid piece in position: " + str);
+            }
+            const Color color = (str[pos++] == 'w') ? Color::White : Color::Black;
+            return parsePiece(str, pos, color);
+        }
+
+        // Marks a piece as seen, throwing if it was already listed
+        void markSeen(std::array<bool, PIECE_COUNT>& seen, const Piece& piece) {
+            const int idx = pieceIndex(piece);
+            if (seen[idx]) {
+                throw std::invalid_argument("Piece listed twice in position: " + PieceToString(piece));
+            }
+            seen[idx] = true;
+        }
+
+        // Checks that the pieces seen on the board and in the hands are those of the game type
+        void checkPieceSet(const std::string& gameType, const std::array<bool, PIECE_COUNT>& seen) {
+            const size_t plus = gameType.find('+');
+            const std::string expansions = (plus == std::string::npos) ? "" : gameType.substr(plus + 1);
+            for (int idx = 0; idx < PIECE_COUNT; ++idx) {
+                const Piece piece = indexToPiece(idx);
+                bool inGame = true;
+                if (piece.bug == Bug::Mosquito) inGame = expansions.find('M') != std::string::npos;
+                if (piece.bug == Bug::Ladybug) inGame = expansions.find('L') != std::string::npos;
+                if (piece.bug == Bug::Pillbug) inGame = expansions.find('P') != std::string::npos;
+
+                if (seen[idx] && !inGame) {
+                    throw std::invalid_argument("Piece not in game type " + gameType + ": " + PieceToString(piece));
+                }
+                if (!seen[idx] && inGame) {
+                    throw std::invalid_argument("Piece neither on the board nor in hand: " + PieceToString(piece));
+                }
+            }
+        }
+
+        std::string handToString(std::uint16_t mask) {
+            std::string str;
+            for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+                if (mask & (1u << i)) str += PieceToString(indexToPiece(i)).substr(1);
+            }
+            return str.empty() ? "-" : str;
+        }
+
+        std::uint16_t stringToHand(const std::string& str, Color color, std::array<bool, PIECE_COUNT>& seen) {
+            std::uint16_t mask = 0;
+            if (str == "-") return mask;
+
+            size_t pos = 0;
+            while (pos < str.size()) {
+                const Piece piece = parsePiece(str, pos, color);
+                markSeen(seen, piece);
+                mask |= static_cast<std::uint16_t>(1u << (pieceIndex(piece) % PIECES_PER_COLOR));
+            }
+            return mask;
+        }
+
+        // Bounding box of the occupied cells, used to store relative coordinates
+        void boundingBox(const Board& board, Coord& minCoord, Coord& maxCoord) {
+            minCoord = {INT32_MAX, INT32_MAX};
+            maxCoord = {INT32_MIN, INT32_MIN};
+            for (const Coord& c : board.occupiedCoords()) {
+                minCoord = {std::min(minCoord.q, c.q), std::min(minCoord.r, c.r)};
+                maxCoord = {std::max(maxCoord.q, c.q), std::max(maxCoord.r, c.r)};
+            }
+        }
+
+        // Translation that centers relative coordinates of a given span on the board origin
+        Coord centerOffset(Coord span) {
+            return {-(span.q / 2), -(span.r / 2)};
+        }
+
+        // Places a stack read from a notation, validating coordinates and height
+        void placeStack(Board& board, Coord coord, const std::vector<Piece>& pieces) {
+            if (!Board::isValid(coord)) {
+                throw std::invalid_argument("Position does not fit on the board");
+            }
+            if (pieces.empty() || pieces.size() > MAX_STACK || !board.empty(coord)) {
+                throw std::invalid_argument("Invalid stack in position");
+            }
+            for (const Piece& p : pieces) board.place(coord, p);
+        }
+    }
+
+    std::vector<Piece> Position::hand(Color player) const {
+        std::vector<Piece> pieces;
+        const std::uint16_t mask = hands[static_cast<int>(player)];
+        for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+            if (mask & (1u << i)) pieces.push_back(indexToPiece(static_cast<int>(player) * PIECES_PER_COLOR + i));
+        }
+        return pieces;
+    }
+
+
+    Position Position::fromBoard(const Board& board, Color turnPlayer) {
+        Position position;
+        position.board = board;
+        position.turnPlayer = turnPlayer;
+
+        int placed = 0;
+        for (int idx = 0; idx < PIECE_COUNT; ++idx) {
+            if (board.contains(indexToPiece(idx))) {
+                ++placed;
+            } else {
+                position.hands[idx / PIECES_PER_COLOR] |= static_cast<std::uint16_t>(1u << (idx % PIECES_PER_COLOR));
+            }
+        }
+        // Without history, passes are unknown: the turn number is estimated from the pieces on the board
+        position.turnNumber = 1 + placed / 2;
+        return position;
+    }
+
+
+    // ----- Make / Unmake -----
+
+    void Position::play(const Move& move) {
+        const bool saveAccumulator = ActiveNetwork() != nullptr;
+        history.push_back({move, lastMoved, saveAccumulator, reversibleFrom});
+        if (saveAccumulator) accumulators.push_back(board.accumulator());
+        history.back().previousLast = pushKey(key());
+        keys.push_back(key());
+
+        if (move.type == Move::Place) {
+            board.place(move.to, move.piece);
+            hands[static_cast<int>(move.piece.color)] &= static_cast<std::uint16_t>(~(1u << (pieceIndex(move.piece) % PIECES_PER_COLOR)));
+            lastMoved = move.piece;
+        } else if (move.type == Move::PieceMove) {
+            board.move(move.from, move.to);
+            lastMoved = move.piece;
+        } else {
+            lastMoved.reset();
+        }
+
+        if (turnPlayer == Color::Black) ++turnNumber;
+        turnPlayer = rival(turnPlayer);
+
+        // A placement adds a piece for good: no earlier position can come back
+        if (move.type == Move::Place) reversibleFrom = keys.size();
+        countRepetitions();
+    }
+
+    void Position::countRepetitions() {
+        const KeyCount& found = keyCounts[findKey(key())];
+        if (found.count == 0) return;
+        Undo& entry = history.back();
+        entry.repetitions = static_cast<int>(found.count);
+        entry.repetitionDistance = static_cast<int>(keys.size() - found.last);
+    }
+
+    void Position::setGameKeys(const std::vector<std::uint64_t>& gameKeys) {
+        assert(history.empty() && "Game keys are set before any move");
+        keys = gameKeys;
+        reversibleFrom = 0;
+        rebuildKeyCounts(keyCounts.size());
+    }
+
+    std::size_t Position::findKey(std::uint64_t key) const {
+        const std::size_t mask = keyCounts.size() - 1;
+        std::size_t i = key & mask;
+        while (keyCounts[i].count != 0 && keyCounts[i].key != key) i = (i + 1) & mask;
+        return i;
+    }
+
+    std::uint32_t Position::pushKey(std::uint64_t key) {
+        if (2 * (distinctKeys + 1) > keyCounts.size()) rebuildKeyCounts(2 * keyCounts.size());
+        KeyCount& slot = keyCounts[findKey(key)];
+        const std::uint32_t previousLast = slot.last;
+        if (slot.count++ == 0) {
+            slot.key = key;
+            ++distinctKeys;
+        }
+        slot.last = static_cast<std::uint32_t>(keys.size());
+        return previousLast;
+    }
+
+    void Position::popKey(std::uint32_t previousLast) {
+        const std::size_t mask = keyCounts.size() - 1;
+        std::size_t i = findKey(keys.back());
+        KeyCount& slot = keyCounts[i];
+        slot.last = previousLast;
+        if (--slot.count > 0) return;
+        --distinctKeys;
+
+        // Backward shift deletion: the keys after the freed slot in its probe run move back if their own slot
+        // is not between the free slot and them
+        for (std::size_t j = (i + 1) & mask; keyCounts[j].count != 0; j = (j + 1) & mask) {
+            const std::size_t home = keyCounts[j].key & mask;
+            const bool stays = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+            if (stays) continue;
+            keyCounts[i] = keyCounts[j];
+            i = j;
+        }
+        keyCounts[i] = KeyCount();
+    }
+
+    void Position::rebuildKeyCounts(std::size_t capacity) {
+        keyCounts.assign(std::max<std::size_t>(capacity, 64), KeyCount());
+        while (2 * keys.size() > keyCounts.size()) keyCounts.resize(2 * keyCounts.size());
+        distinctKeys = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            KeyCount& slot = keyCounts[findKey(keys[i])];
+            if (slot.count++ == 0) {
+                slot.key = keys[i];
+                ++distinctKeys;
+            }
+            slot.last = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    void Position::undo() {
+        assert(!history.empty() && "Nothing to undo");
+        const Undo entry = history.back();
+        history.pop_back();
+
+        turnPlayer = rival(turnPlayer);
+        if (turnPlayer == Color::Black) --turnNumber;
+
+        // The saved accumulator replaces the updates of the board operations
+        if (entry.savedAccumulator) board.pauseAccumulator();
+
+        const Move& move = entry.move;
+        if (move.type == Move::Place) {
+            board.remove(move.to);
+            hands[static_cast<int>(move.piece.color)] |= static_cast<std::uint16_t>(1u << (pieceIndex(move.piece) % PIECES_PER_COLOR));
+        } else if (move.type == Move::PieceMove) {
+            board.move(move.to, move.from);
+        }
+        lastMoved = entry.lastMoved;
+        popKey(entry.previousLast);
+        keys.pop_back();
+        reversibleFrom = entry.reversibleFrom;
+
+        if (entry.savedAccumulator) {
+            board.restoreAccumulator(accumulators.back());
+            accumulators.pop_back();
+        }
+    }
+
+    std::vector<Move> Position::generateMoves() const {
+        return RuleEngine::generateMoves(board, turnPlayer, hand(turnPlayer), lastMoved);
+    }
+
+    std::vector<Move> Position::generatePieceMoves() const {
+        return RuleEngine::generatePieceMoves(board, turnPlayer, lastMoved);
+    }
+
+    std::vector<Move> Position::generatePlacements() const {
+        return RuleEngine::generatePlacements(board, turnPlayer, hand(turnPlayer));
+    }
+
+    std::vector<Move> Position::generateQueenThreats(int minPressure) const {
+        return RuleEngine::generateQueenThreats(board, turnPlayer, lastMoved, minPressure);
+    }
+
+    int Position::queenPressure(Color player) const {
+        Coord queen;
+        if (!board.locate({player, Bug::Queen, 0}, queen)) return 0;
+        return board.occupiedNeighbors(queen);
+    }
+
+    bool Position::isQueenSurrounded(Color player) const {
+        return queenPressure(player) == 6;
+    }
+
+
+    // ----- Text Notation -----
+
+    std::string PositionToString(const Position& position) {
+        std::string str = position.gameType + ";" + std::string(colorName(position.turnPlayer)) +
+                          "[" + std::to_string(position.turnNumber) + "];";
+        str += position.lastMoved ? PieceToString(*position.lastMoved) : "-";
+        str += ";";
+
+        // Stacks sorted by (r, q) so that equal positions give equal strings
+        std::vector<Coord> coords = position.board.occupiedCoords();
+        std::sort(coords.begin(), coords.end(), [](const Coord& a, const Coord& b) {
+            if (a.r != b.r) return a.r < b.r;
+            return a.q < b.q;
+        });
+
+        Coord minCoord, maxCoord;
+        boundingBox(position.board, minCoord, maxCoord);
+
+        for (size_t i = 0; i < coords.size(); ++i) {
+            const Coord rel = coords[i] - minCoord;
+            if (i > 0) str += "/";
+            str += std::to_string(rel.q) + "," + std::to_string(rel.r) + "=";
+            for (const Piece& p : position.board.cell(coords[i])) str += PieceToString(p);
+        }
+        if (coords.empty()) str += "-";
+
+        str += ";" + handToString(position.hands[0]);
+        str += ";" + handToString(position.hands[1]);
+        return str;
+    }
+
+    bool IsGameType(const std::string& str) {
+        if (str == "Base") return true;
+        if (str.rfind("Base+", 0) != 0 || str.size() == 5) return false;
+        size_t next = 0;
+        for (size_t i = 5; i < str.size(); ++i) {
+            const size_t letter = std::string_view("MLP").find(str[i], next);
+            if (letter == std::string_view::npos) return false;
+            next = letter + 1;
+        }
+        return true;
+    }
+
+    Position StringToPosition(const std::string& str) {
+        std::vector<std::string> fields;
+        std::istringstream stream(str);
+        std::string field;
+        while (std::getline(stream, field, ';')) fields.push_back(field);
+
+        if (fields.size() != 6) {
+            throw std::invalid_argument("Position must have 6 fields: " + str);
+        }
+
+        Position position;
+        if (!IsGameType(fields[0])) {
+            throw std::invalid_argument("Invalid game type: " + fields[0]);
+        }
+        position.gameType = fields[0];
+
+        // Turn String
+        const std::string& turn = fields[1];
+        const size_t open = turn.find('[');
+        if (open == std::string::npos || turn.back() != ']') {
+            throw std::invalid_argument("Invalid turn string: " + turn);
+        }
+        const std::string colorStr = turn.substr(0, open);
+        if (colorStr != "White" && colorStr != "Black") {
+            throw std::invalid_argument("Invalid turn string: " + turn);
+        }
+        position.turnPlayer = (colorStr == "White") ? Color::White : Color::Black;
+        position.turnNumber = std::stoi(turn.substr(open + 1, turn.size() - open - 2));
+        if (position.turnNumber < 1) {
+            throw std::invalid_argument("Invalid turn number: " + turn);
+        }
+
+        // Last Moved
+        if (fields[2] != "-") {
+            size_t pos = 0;
+            position.lastMoved = parseColoredPiece(fields[2], pos);
+        }
+
+        std::array<bool, PIECE_COUNT> seen{};
+
+        // Stacks: first pass reads relative coordinates, second pass centers them on the board
+        std::vector<std::pair<Coord, std::vector<Piece>>> stacks;
+        Coord span{0, 0};
+        if (fields[3] != "-") {
+            std::istringstream stackStream(fields[3]);
+            std::string stackStr;
+            while (std::getline(stackStream, stackStr, '/')) {
+                const size_t comma = stackStr.find(',');
+                const size_t equal = stackStr.find('=');
+                if (comma == std::string::npos || equal == std::string::npos || equal < comma) {
+                    throw std::invalid_argument("Invalid stack: " + stackStr);
+                }
+                const Coord rel{std::stoi(stackStr.substr(0, comma)), std::stoi(stackStr.substr(comma + 1, equal - comma - 1))};
+                if (rel.q < 0 || rel.r < 0) {
+                    throw std::invalid_argument("Invalid stack coordinates: " + stackStr);
+                }
+
+                std::vector<Piece> pieces;
+                size_t pos = equal + 1;
+                while (pos < stackStr.size()) {
+                    Piece p = parseColoredPiece(stackStr, pos);
+                    markSeen(seen, p);
+                    pieces.push_back(p);
+                }
+
+                span = {std::max(span.q, rel.q), std::max(span.r, rel.r)};
+                stacks.emplace_back(rel, std::move(pieces));
+            }
+        }
+
+        const Coord offset = centerOffset(span);
+        for (const auto& [rel, pieces] : stacks) {
+            placeStack(position.board, rel + offset, pieces);
+        }
+
+        // Hands
+        position.hands[0] = stringToHand(fields[4], Color::White, seen);
+        position.hands[1] = stringToHand(fields[5], Color::Black, seen);
+        checkPieceSet(position.gameType, seen);
+
+        return position;
+    }
+
+
+    // ----- Binary Notation -----
+
+    std::vector<std::uint8_t> PositionToBytes(const Position& position) {
+        std::vector<std::uint8_t> bytes;
+        bytes.reserve(9 + 3 * position.board.occupiedCoords().size() + PIECE_COUNT);
+
+        const size_t plus = position.gameType.find('+');
+        const std::string expansions = (plus == std::string::npos) ? "" : position.gameType.substr(plus + 1);
+
+        std::uint8_t flags = static_cast<std::uint8_t>(position.turnPlayer);
+        if (position.lastMoved) flags |= 1u << 1;
+        if (expansions.find('M') != std::string::npos) flags |= 1u << 2;
+        if (expansions.find('L') != std::string::npos) flags |= 1u << 3;
+        if (expansions.find('P') != std::string::npos) flags |= 1u << 4;
+
+        bytes.push_back(flags);
+        bytes.push_back(static_cast<std::uint8_t>(position.turnNumber & 0xFF));
+        bytes.push_back(static_cast<std::uint8_t>((position.turnNumber >> 8) & 0xFF));
+        bytes.push_back(position.lastMoved ? static_cast<std::uint8_t>(pieceIndex(*position.lastMoved)) : 0);
+        for (std::uint16_t mask : position.hands) {
+            bytes.push_back(static_cast<std::uint8_t>(mask & 0xFF));
+            bytes.push_back(static_cast<std::uint8_t>(mask >> 8));
+        }
+
+        Coord minCoord, maxCoord;
+        boundingBox(position.board, minCoord, maxCoord);
+
+        bytes.push_back(static_cast<std::uint8_t>(position.board.occupiedCoords().size()));
+        for (const Coord& c : position.board.occupiedCoords()) {
+            const Coord rel = c - minCoord;
+            const Board::Cell& cell = position.board.cell(c);
+            bytes.push_back(static_cast<std::uint8_t>(rel.q));
+            bytes.push_back(static_cast<std::uint8_t>(rel.r));
+            bytes.push_back(static_cast<std::uint8_t>(cell.size()));
+            for (const Piece& p : cell) bytes.push_back(static_cast<std::uint8_t>(pieceIndex(p)));
+        }
+        return bytes;
+    }
+
+    Position BytesToPosition(const std::vector<std::uint8_t>& bytes) {
+        size_t pos = 0;
+        auto next = [&]() -> std::uint8_t {
+            if (pos >= bytes.size()) throw std::invalid_argument("Truncated binary position");
+            return bytes[pos++];
+        };
+        auto nextPiece = [&]() -> Piece {
+            const std::uint8_t idx = next();
+            if (idx >= PIECE_COUNT) throw std::invalid_argument("Invalid piece index in binary position");
+            return indexToPiece(idx);
+        };
+
+        Position position;
+        const std::uint8_t flags = next();
+        position.turnPlayer = (flags & 1u) ? Color::Black : Color::White;
+
+        std::string expansions;
+        if (flags & (1u << 2)) expansions += "M";
+        if (flags & (1u << 3)) expansions += "L";
+        if (flags & (1u << 4)) expansions += "P";
+        position.gameType = expansions.empty() ? "Base" : "Base+" + expansions;
+
+        position.turnNumber = next();
+        position.turnNumber |= next() << 8;
+        const Piece lastMoved = nextPiece();
+        if (flags & (1u << 1)) position.lastMoved = lastMoved;
+
+        std::array<bool, PIECE_COUNT> seen{};
+        for (int color = 0; color < 2; ++color) {
+            std::uint16_t mask = next();
+            mask |= static_cast<std::uint16_t>(next() << 8);
+            for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+                if (mask & (1u << i)) markSeen(seen, indexToPiece(color * PIECES_PER_COLOR + i));
+            }
+            position.hands[color] = mask;
+        }
+
+        const int stackCount = next();
+        std::vector<std::pair<Coord, std::vector<Piece>>> stacks(stackCount);
+        Coord span{0, 0};
+        for (auto& [rel, pieces] : stacks) {
+            rel.q = next();
+            rel.r = next();
+            const int height = next();
+            for (int i = 0; i < height; ++i) {
+                pieces.push_back(nextPiece());
+                markSeen(seen, pieces.back());
+            }
+            span = {std::max(span.q, rel.q), std::max(span.r, rel.r)};
+        }
+
+        const Coord offset = centerOffset(span);
+        for (const auto& [rel, pieces] : stacks) {
+            placeStack(position.board, rel + offset, pieces);
+        }
+        checkPieceSet(position.gameType, seen);
+        return position;
+    }
+
+    std::string BytesToHex(const std::vector<std::uint8_t>& bytes) {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(2 * bytes.size());
+        for (std::uint8_t b : bytes) {
+            hex += DIGITS[b >> 4];
+            hex += DIGITS[b & 0xF];
+        }
+        return hex;
+    }
+
+    std::vector<std::uint8_t> HexToBytes(const std::string& hex) {
+        auto nibble = [&](char c) -> std::uint8_t {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            throw std::invalid_argument("Invalid hex string: " + hex);
+        };
+
+        if (hex.size() % 2 != 0) throw std::invalid_argument("Invalid hex string: " + hex);
+
+        std::vector<std::uint8_t> bytes(hex.size() / 2);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<std::uint8_t>((nibble(hex[2 * i]) << 4) | nibble(hex[2 * i + 1]));
+        }
+        return bytes;
+    }
+
+}
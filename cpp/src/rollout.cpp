@@ -0,0 +1,166 @@
+#include "headers/rollout.h"
+#include "headers/rules.h"
+
+#include <cstdlib>
+
+namespace Hive {
+
+    namespace {
+        // Random (stack, direction) draws before a placement falls back to a scan of every cell around the own stacks
+        constexpr int PLACEMENT_TRIES = 12;
+
+        // Returns True if cell is the rival Queen cell (a Beetle climbing on it) or one of its neighbors
+        bool touchesQueen(const Coord& cell, const Coord& queen) {
+            const int dq = cell.q - queen.q;
+            const int dr = cell.r - queen.r;
+            return std::abs(dq) + std::abs(dr) + std::abs(dq + dr) <= 2;
+        }
+    }
+
+    Move RolloutPolicy::sample(const Position& pos) {
+        const Board& board = pos.board;
+        const Color player = pos.turnPlayer;
+        const int base = static_cast<int>(player) * PIECES_PER_COLOR;
+
+        // First placements of the game: every cell around the first piece is legal, the full generation is as cheap
+        if (board.occupiedCoords().size() < 2) return sampleGenerated(pos);
+
+        int placedCount = 0;
+        for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+            if (board.contains(indexToPiece(base + i))) ++placedCount;
+        }
+        const bool queenPlaced = board.contains({player, Bug::Queen, 0});
+        rivalQueenPlaced = board.locate({rival(player), Bug::Queen, 0}, rivalQueen);
+
+        // ----- Candidates -----
+        candidates.clear();
+        ownStacks.clear();
+        for (const Coord& c : board.occupiedCoords()) {
+            if (board.top(c)->color != player) continue;
+            ownStacks.push_back(c);
+            // Pieces can move only once the player's Queen is on the board, and not right after a Pillbug threw them
+            if (queenPlaced && !(pos.lastMoved && *pos.lastMoved == *board.top(c))) candidates.push_back({false, c, 0});
+        }
+
+        const std::uint16_t hand = pos.hands[static_cast<int>(player)];
+        const bool queenForced = placedCount == 3 && (hand & 1u);
+        for (int bug = 0; bug < static_cast<int>(BUG_COUNT.size()); ++bug) {
+            if (queenForced && bug != static_cast<int>(Bug::Queen)) break;
+            if (placedCount == 0 && bug == static_cast<int>(Bug::Queen)) continue;
+            // Only the lowest id of each bug in hand can be placed
+            for (int local = BUG_OFFSET[bug]; local < BUG_OFFSET[bug] + BUG_COUNT[bug]; ++local) {
+                if (hand & (1u << local)) {
+                    candidates.push_back({true, {0, 0}, local});
+                    break;
+                }
+            }
+        }
+
+        // ----- Draw -----
+        // The placement cells do not depend on the bug: once a scan found none, no placement candidate can succeed
+        bool placementsExhausted = false;
+        Move move = PASS_MOVE;
+        while (!candidates.empty()) {
+            const std::size_t i = std::uniform_int_distribution<std::size_t>(0, candidates.size() - 1)(rng);
+            const Candidate candidate = candidates[i];
+            if (candidate.placement) {
+                if (!placementsExhausted) {
+                    if (samplePlacement(pos, candidate, move)) return move;
+                    placementsExhausted = true;
+                }
+            } else if (samplePieceMove(pos, candidate, move)) {
+                return move;
+            }
+            candidates[i] = candidates.back();
+            candidates.pop_back();
+        }
+
+        // No placement nor movement: a Pillbug throw, or a pass
+        return sampleGenerated(pos);
+    }
+
+    bool RolloutPolicy::samplePieceMove(const Position& pos, const Candidate& candidate, Move& move) {
+        const Board& board = pos.board;
+        if (!RuleEngine::canLift(board, candidate.from)) return false;
+
+        const Piece piece = *board.top(candidate.from);
+        targets.clear();
+        RuleEngine::getTargets(board, candidate.from, piece, targets);
+        if (targets.empty()) return false;
+
+        // Weighted reservoir sampling: each target replaces the pick with probability weight / weight so far
+        const bool biased = rivalQueenPlaced && attackWeight != 1.0;
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        double total = 0.0;
+        const Coord* pick = nullptr;
+        for (const Coord& to : targets) {
+            const double weight = (biased && touchesQueen(to, rivalQueen)) ? attackWeight : 1.0;
+            total += weight;
+            if (pick == nullptr || uniform(rng) * total < weight) pick = &to;
+        }
+
+        move = {Move::PieceMove, piece, candidate.from, *pick};
+        return true;
+    }
+
+    bool RolloutPolicy::samplePlacement(const Position& pos, const Candidate& candidate, Move& move) {
+        const Board& board = pos.board;
+        const Color player = pos.turnPlayer;
+        const Piece piece = indexToPiece(static_cast<int>(player) * PIECES_PER_COLOR + candidate.local);
+        if (ownStacks.empty()) return false;
+
+        // Rejection sampling around a random own stack
+        std::uniform_int_distribution<std::size_t> stackDist(0, ownStacks.size() - 1);
+        std::uniform_int_distribution<int> dirDist(0, 5);
+        for (int t = 0; t < PLACEMENT_TRIES; ++t) {
+            const Coord cell = coordNeighbors(ownStacks[stackDist(rng)])[dirDist(rng)];
+            if (RuleEngine::isPlacementCell(board, player, cell)) {
+                move = {Move::Place, piece, {0, 0}, cell};
+                return true;
+            }
+        }
+
+        // Crowded hive: reservoir sampling over every cell around the own stacks
+        std::size_t seen = 0;
+        for (const Coord& stack : ownStacks) {
+            for (const Coord& cell : coordNeighbors(stack)) {
+                if (!RuleEngine::isPlacementCell(board, player, cell)) continue;
+                if (std::uniform_int_distribution<std::size_t>(0, seen++)(rng) == 0) {
+                    move = {Move::Place, piece, {0, 0}, cell};
+                }
+            }
+        }
+        return seen > 0;
+    }
+
+    Move RolloutPolicy::sampleGenerated(const Position& pos) {
+        const std::vector<Move> moves = pos.generateMoves();
+        if (moves.empty()) return PASS_MOVE;
+        return moves[std::uniform_int_distribution<std::size_t>(0, moves.size() - 1)(rng)];
+    }
+
+    float RolloutPolicy::playout(Position& pos, int maxPlies, int& plies) {
+        const Color player = pos.turnPlayer;
+        float result = 0.0f;
+        plies = 0;
+        while (true) {
+            const bool whiteSurrounded = pos.isQueenSurrounded(Color::White);
+            const bool blackSurrounded = pos.isQueenSurrounded(Color::Black);
+            if (whiteSurrounded || blackSurrounded) {
+                if (whiteSurrounded != blackSurrounded) {
+                    const Color loser = whiteSurrounded ? Color::White : Color::Black;
+                    result = (loser == player) ? -1.0f : 1.0f;
+                }
+                break;
+            }
+            if (plies >= maxPlies) break;
+
+            pos.play(sample(pos));
+            ++plies;
+        }
+
+        for (int i = 0; i < plies; ++i) pos.undo();
+        return result;
+    }
+
+}
@@ -89,23 +89,286 @@ namespace Hive{
         return true;
     }
 
-    std::vector<Move> generatePlacements(const Board& board, Color player, const std::vector<Piece>& hand) {
-        return;
-        // TODO: write function
+    bool RuleEngine::canLift(const Board& board, Coord from) {
+        return isBoardConnected(board, Board::AxToIndex(from));
     }
 
-    std::vector<Move> generateMovements(const Board& board, Color player) {
-        return;
-        // TODO: write function
+    bool RuleEngine::isPlacementCell(const Board& board, Color player, Coord cell) {
+        const int idx = Board::AxToIndex(cell);
+        if (!board._grid[idx].empty()) return false;
+
+        bool touchesOwn = false;
+        for (int offset : Board::NEIGHBORS) {
+            const Board::Cell& neigh = board._grid[idx + offset];
+            if (neigh.empty()) continue;
+            if (neigh.top().color != player) return false;
+            touchesOwn = true;
+        }
+        return touchesOwn;
+    }
+
+    std::vector<Move> RuleEngine::generatePlacements(const Board& board, Color player, const std::vector<Piece>& hand) {
+        std::vector<Move> placements;
+        if (hand.empty()) return placements;
+
+        // Placeable pieces: the lowest id of each bug
+        std::array<bool, 8> bugSeen{};
+        std::vector<Piece> placeable;
+        bool queenInHand = false;
+        for (const Piece& p : hand) {
+            const int bug = static_cast<int>(p.bug);
+            if (p.bug == Bug::Queen) queenInHand = true;
+            if (bugSeen[bug]) continue;
+            bugSeen[bug] = true;
+
+            Piece lowest = p;
+            for (const Piece& other : hand) {
+                if (other.bug == p.bug && other.id < lowest.id) lowest = other;
+            }
+            placeable.push_back(lowest);
+        }
+
+        int placedCount = 0;
+        for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+            if (board.contains(indexToPiece(static_cast<int>(player) * PIECES_PER_COLOR + i))) ++placedCount;
+        }
+
+        // Queen rules
+        if (placedCount == 0) {
+            placeable.erase(std::remove_if(placeable.begin(), placeable.end(),
+                                           [](const Piece& p) { return p.bug == Bug::Queen; }), placeable.end());
+        } else if (placedCount == 3 && queenInHand) {
+            placeable = {{player, Bug::Queen, 0}};
+        }
+
+        // Candidate cells
+        std::vector<Coord> cells;
+        const std::vector<Coord>& occupied = board.occupiedCoords();
+        if (occupied.empty()) {
+            cells.push_back({0, 0});
+        } else if (placedCount == 0) {
+            // Second piece of the game: anywhere around the first one
+            for (const Coord& n : coordNeighbors(occupied.front())) cells.push_back(n);
+        } else {
+            std::bitset<BOARD_AREA> checked;
+            for (const Coord& c : occupied) {
+                const int cIdx = Board::AxToIndex(c);
+                if (board._grid[cIdx].top().color != player) continue;
+
+                for (int i = 0; i < 6; ++i) {
+                    const int nIdx = cIdx + Board::NEIGHBORS[i];
+                    if (checked.test(nIdx) || !board._grid[nIdx].empty()) continue;
+                    checked.set(nIdx);
+
+                    // A placed piece cannot touch any rival piece
+                    bool touchesRival = false;
+                    for (int offset : Board::NEIGHBORS) {
+                        const Board::Cell& neigh = board._grid[nIdx + offset];
+                        if (!neigh.empty() && neigh.top().color != player) {
+                            touchesRival = true;
+                            break;
+                        }
+                    }
+                    if (!touchesRival) cells.push_back(Board::IndexToAx(nIdx));
+                }
+            }
+        }
+
+        placements.reserve(cells.size() * placeable.size());
+        for (const Piece& p : placeable) {
+            for (const Coord& c : cells) {
+                placements.push_back({Move::Place, p, {0, 0}, c});
+            }
+        }
+        return placements;
+    }
+
+    void RuleEngine::getTargets(const Board& board, Coord from, const Piece& piece, std::vector<Coord>& targets) {
+        switch (piece.bug) {
+            case Bug::Queen:       Moves::getQueenMoves(board, from, targets); break;
+            case Bug::Beetle:      Moves::getBeetleMoves(board, from, targets); break;
+            case Bug::Spider:      Moves::getSpiderMoves(board, from, targets); break;
+            case Bug::Grasshopper: Moves::getGrasshopperMoves(board, from, targets); break;
+            case Bug::Ant:         Moves::getAntMoves(board, from, targets); break;
+            case Bug::Ladybug:     Moves::getLadybugMoves(board, from, targets); break;
+            case Bug::Mosquito:    Moves::getMosquitoMoves(board, from, targets); break;
+            case Bug::Pillbug:     Moves::getPillbugMoves(board, from, targets); break;
+        }
+    }
+
+    std::vector<Move> RuleEngine::generateMovements(const Board& board, Color player, const std::optional<Piece>& lastMoved) {
+        std::vector<Move> movements;
+        if (!board.contains({player, Bug::Queen, 0})) return movements;
+
+        std::vector<Coord> targets;
+        targets.reserve(64);
+
+        for (const Coord& from : board.occupiedCoords()) {
+            const int fromIdx = Board::AxToIndex(from);
+            const Piece piece = board._grid[fromIdx].top();
+            if (piece.color != player) continue;
+            // A piece the rival Pillbug just threw cannot move this turn
+            if (lastMoved && *lastMoved == piece) continue;
+            if (!isBoardConnected(board, fromIdx)) continue;
+
+            targets.clear();
+            getTargets(board, from, piece, targets);
+
+            for (const Coord& to : targets) {
+                movements.push_back({Move::PieceMove, piece, from, to});
+            }
+        }
+        return movements;
+    }
+
+    bool RuleEngine::canPassAtLevel(const Board& board, int fromIdx, int toIdx, int level) {
+        const int diff = toIdx - fromIdx;
+        for (int dir = 0; dir < 6; ++dir) {
+            if (Board::NEIGHBORS[dir] != diff) continue;
+            const int gate1 = fromIdx + Board::NEIGHBORS[(dir + 5) % 6];
+            const int gate2 = fromIdx + Board::NEIGHBORS[(dir + 1) % 6];
+            return !(board._grid[gate1].size() >= level && board._grid[gate2].size() >= level);
+        }
+        return false;
     }
 
-    std::vector<Move> generateMoves(const Board& board, Color turnPlayer, const std::vector<Piece>& hand) {
+    void RuleEngine::generateThrows(const Board& board, Color player, const std::optional<Piece>& lastMoved, std::vector<Move>& moves) {
+        if (!board.contains({player, Bug::Queen, 0})) return;
+
+        for (const Bug bug : {Bug::Pillbug, Bug::Mosquito}) {
+            const Piece user{player, bug, 0};
+            Coord userCoord;
+            if (!board.locate(user, userCoord)) continue;
+            if (lastMoved && *lastMoved == user) continue;
+
+            // The user must be on the ground, on top of nothing and under nothing
+            const int userIdx = Board::AxToIndex(userCoord);
+            if (board._grid[userIdx].size() != 1) continue;
+
+            // A Mosquito gets the ability only from a Pillbug it touches
+            if (bug == Bug::Mosquito) {
+                bool touchesPillbug = false;
+                for (int offset : Board::NEIGHBORS) {
+                    const Board::Cell& neigh = board._grid[userIdx + offset];
+                    if (!neigh.empty() && neigh.top().bug == Bug::Pillbug) touchesPillbug = true;
+                }
+                if (!touchesPillbug) continue;
+            }
+
+            for (int offset : Board::NEIGHBORS) {
+                const int fromIdx = userIdx + offset;
+                const Board::Cell& cell = board._grid[fromIdx];
+                if (cell.size() != 1) continue;
+
+                const Piece thrown = cell.top();
+                if (lastMoved && *lastMoved == thrown) continue;
+                if (!isBoardConnected(board, fromIdx)) continue;
+
+                // The thrown piece climbs on the user (level 2) and comes down on the other side
+                if (!canPassAtLevel(board, fromIdx, userIdx, 2)) continue;
+
+                for (int toOffset : Board::NEIGHBORS) {
+                    const int toIdx = userIdx + toOffset;
+                    if (toIdx == fromIdx || !board._grid[toIdx].empty()) continue;
+                    if (!canPassAtLevel(board, userIdx, toIdx, 2)) continue;
+
+                    const Move m{Move::PieceMove, thrown, Board::IndexToAx(fromIdx), Board::IndexToAx(toIdx)};
+                    if (std::find(moves.begin(), moves.end(), m) == moves.end()) moves.push_back(m);
+                }
+            }
+        }
+    }
+
+    std::vector<Move> RuleEngine::generateQueenThreats(const Board& board, Color turnPlayer, const std::optional<Piece>& lastMoved, int minPressure) {
+        std::vector<Move> threats;
+        Coord ownQueen, rivalQueen;
+        if (!board.locate({turnPlayer, Bug::Queen, 0}, ownQueen)) return threats;
+        const bool rivalPlaced = board.locate({rival(turnPlayer), Bug::Queen, 0}, rivalQueen);
+
+        // Hot cells: each Queen under pressure with its neighbors
+        auto pressure = [&](int qIdx) {
+            int occupied = 0;
+            for (int offset : Board::NEIGHBORS) occupied += !board._grid[qIdx + offset].empty();
+            return occupied;
+        };
+        std::bitset<BOARD_AREA> ownHot, rivalHot;
+        const int ownIdx = Board::AxToIndex(ownQueen);
+        const bool ownThreatened = pressure(ownIdx) >= minPressure;
+        if (ownThreatened) {
+            ownHot.set(ownIdx);
+            for (int offset : Board::NEIGHBORS) ownHot.set(ownIdx + offset);
+        }
+        const bool rivalThreatened = rivalPlaced && pressure(Board::AxToIndex(rivalQueen)) >= minPressure;
+        if (rivalThreatened) {
+            const int rivalIdx = Board::AxToIndex(rivalQueen);
+            rivalHot.set(rivalIdx);
+            for (int offset : Board::NEIGHBORS) rivalHot.set(rivalIdx + offset);
+        }
+        if (!ownThreatened && !rivalThreatened) return threats;
+
+        // A move threatens if it frees the own Queen or closes on the rival one
+        auto isThreat = [&](int fromIdx, int toIdx) {
+            return (ownHot.test(fromIdx) && !ownHot.test(toIdx)) || rivalHot.test(toIdx);
+        };
+
+        std::vector<Coord> targets;
+        targets.reserve(64);
+
+        for (const Coord& from : board.occupiedCoords()) {
+            const int fromIdx = Board::AxToIndex(from);
+            const Piece piece = board._grid[fromIdx].top();
+            if (piece.color != turnPlayer) continue;
+            if (lastMoved && *lastMoved == piece) continue;
+
+            const bool isQueen = (piece.bug == Bug::Queen) && ownThreatened;
+            if (!isQueen && !ownHot.test(fromIdx)) {
+                if (!rivalThreatened) continue;
+
+                // Steps a piece can cover, 0 if unbounded (Ant, Grasshopper, Mosquito on the ground)
+                int range = 0;
+                switch (piece.bug) {
+                    case Bug::Beetle: case Bug::Pillbug: range = 1; break;
+                    case Bug::Spider: case Bug::Ladybug: range = 3; break;
+                    case Bug::Mosquito: range = (board._grid[fromIdx].size() > 1) ? 1 : 0; break;
+                    default: break;
+                }
+                // Hot cells are within one step of the rival Queen
+                if (range > 0 && hexDistance(from, rivalQueen) > range + 1) continue;
+            }
+            if (!isBoardConnected(board, fromIdx)) continue;
+
+            targets.clear();
+            getTargets(board, from, piece, targets);
+            for (const Coord& to : targets) {
+                // The own Queen changes its whole neighborhood when it moves
+                if (isQueen || isThreat(fromIdx, Board::AxToIndex(to))) threats.push_back({Move::PieceMove, piece, from, to});
+            }
+        }
+
+        std::vector<Move> throws;
+        generateThrows(board, turnPlayer, lastMoved, throws);
+        for (const Move& m : throws) {
+            if (!isThreat(Board::AxToIndex(m.from), Board::AxToIndex(m.to))) continue;
+            if (std::find(threats.begin(), threats.end(), m) == threats.end()) threats.push_back(m);
+        }
+        return threats;
+    }
+
+    std::vector<Move> RuleEngine::generateMoves(const Board& board, Color turnPlayer, const std::vector<Piece>& hand,
+                                                const std::optional<Piece>& lastMoved) {
         std::vector<Move> placements = generatePlacements(board, turnPlayer, hand);
 
-        std::vector<Move> movements = generateMovements(board, turnPlayer);
+        std::vector<Move> movements = generateMovements(board, turnPlayer, lastMoved);
+        generateThrows(board, turnPlayer, lastMoved, movements);
 
         placements.insert(placements.end(), movements.begin(), movements.end());
 
         return placements;
     }
+
+    std::vector<Move> RuleEngine::generatePieceMoves(const Board& board, Color turnPlayer, const std::optional<Piece>& lastMoved) {
+        std::vector<Move> movements = generateMovements(board, turnPlayer, lastMoved);
+        generateThrows(board, turnPlayer, lastMoved, movements);
+        return movements;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "headers/symmetry.h"
+#include "headers/zobrist.h"
+
+#include <unordered_set>
+
+namespace Hive {
+
+    Move Canonical::apply(Move move) const {
+        if (move.type == Move::Pass) return move;
+        move.to = apply(move.to);
+        if (move.type == Move::PieceMove) move.from = apply(move.from);
+        return move;
+    }
+
+    Move Canonical::undo(Move move) const {
+        if (move.type == Move::Pass) return move;
+        move.to = undo(move.to);
+        if (move.type == Move::PieceMove) move.from = undo(move.from);
+        return move;
+    }
+
+    Position Canonical::apply(const Position& pos) const {
+        Position out;
+        out.gameType = pos.gameType;
+        out.turnPlayer = pos.turnPlayer;
+        out.turnNumber = pos.turnNumber;
+        out.lastMoved = pos.lastMoved;
+        out.hands = pos.hands;
+        for (const Coord& c : pos.board.occupiedCoords()) {
+            for (const Piece& p : pos.board.cell(c)) out.board.place(apply(c), p);
+        }
+        return out;
+    }
+
+    Canonical Canonicalize(const Position& pos) {
+        const std::vector<Coord>& occupied = pos.board.occupiedCoords();
+        const std::uint64_t side = (pos.turnPlayer == Color::Black) ? ZOBRIST_BLACK_TO_MOVE : 0;
+
+        Canonical best;
+        for (int symmetry = 0; symmetry < SYMMETRY_COUNT; ++symmetry) {
+            Coord anchor{0, 0};
+            for (std::size_t i = 0; i < occupied.size(); ++i) {
+                const Coord c = transformCoord(occupied[i], symmetry);
+                if (i == 0 || c.r < anchor.r || (c.r == anchor.r && c.q < anchor.q)) anchor = c;
+            }
+
+            // The key Board::place would give the pieces in this orientation
+            std::uint64_t key = side;
+            for (const Coord& c : occupied) {
+                const int cell = Board::AxToIndex(transformCoord(c, symmetry) - anchor);
+                int level = 0;
+                for (const Piece& p : pos.board.cell(c)) key ^= zobristPiece(pieceIndex(p), cell, level++);
+            }
+            if (symmetry == 0 || key < best.key) best = {key, symmetry, anchor};
+        }
+        return best;
+    }
+
+    std::vector<Move> UniqueMoves(const Position& pos, const std::vector<Move>& moves) {
+        Position work = pos;
+        std::unordered_set<std::uint64_t> seen;
+        std::vector<Move> unique;
+        unique.reserve(moves.size());
+        for (const Move& move : moves) {
+            if (move.type == Move::Pass) {
+                unique.push_back(move);
+                continue;
+            }
+            work.play(move);
+            const std::uint64_t child = CanonicalKey(work) ^ splitmix64(static_cast<std::uint64_t>(pieceIndex(move.piece)));
+            work.undo();
+            if (seen.insert(child).second) unique.push_back(move);
+        }
+        return unique;
+    }
+
+}
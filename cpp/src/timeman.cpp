@@ -0,0 +1,74 @@
+#include "headers/timeman.h"
+
+#include <algorithm>
+#include <array>
+
+namespace Hive {
+
+    namespace {
+        // Share of the move time kept for the reply, capped at MAX_REPLY_MARGIN
+        constexpr int REPLY_MARGIN_DIVISOR = 20;
+        constexpr std::chrono::milliseconds MAX_REPLY_MARGIN{100};
+
+        // Soft deadline factor by consecutive iterations on the same best move: 0 when it just changed
+        constexpr std::array<double, 5> STABILITY_SCALE = {1.25, 1.0, 0.8, 0.65, 0.5};
+
+        // Score drops since the previous iteration (centi-pieces) lengthening the soft deadline
+        constexpr int SCORE_DROP = 30;
+        constexpr double SCORE_DROP_SCALE = 1.5;
+        constexpr int SCORE_COLLAPSE = 100;
+        constexpr double SCORE_COLLAPSE_SCALE = 2.0;
+    }
+
+    void TimeManager::start(const SearchLimits& limits) {
+        startTime = Clock::now();
+        isTimed = limits.moveTime < NO_TIME_LIMIT;
+        const std::chrono::milliseconds margin = std::min(limits.moveTime / REPLY_MARGIN_DIVISOR, MAX_REPLY_MARGIN);
+        hardLimit = std::max(limits.moveTime - margin, std::chrono::milliseconds(1));
+        soft = hardLimit / 2;
+        iterations = 0;
+        stableIterations = 0;
+        lastBest = PASS_MOVE;
+        lastScore = 0;
+    }
+
+    bool TimeManager::iterationDone(const Move& bestMove, int score) {
+        if (iterations > 0) stableIterations = (bestMove == lastBest) ? stableIterations + 1 : 0;
+        else stableIterations = 1;
+
+        double scale = STABILITY_SCALE[std::min<std::size_t>(stableIterations, STABILITY_SCALE.size() - 1)];
+        if (iterations > 0) {
+            const int drop = lastScore - score;
+            if (drop >= SCORE_COLLAPSE) scale *= SCORE_COLLAPSE_SCALE;
+            else if (drop >= SCORE_DROP) scale *= SCORE_DROP_SCALE;
+        }
+
+        ++iterations;
+        lastBest = bestMove;
+        lastScore = score;
+
+        const auto scaled = std::chrono::milliseconds(static_cast<long long>(static_cast<double>((hardLimit / 2).count()) * scale));
+        soft = std::min(scaled, hardLimit);
+        return elapsed() >= soft;
+    }
+
+    Watchdog::Watchdog(std::atomic<bool>& stop, TimeManager::Clock::time_point deadline) {
+        thread = std::thread([this, &stop, deadline] {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!wake.wait_until(lock, deadline, [this] { return cancelled; })) {
+                hasFired = true;
+                stop = true;
+            }
+        });
+    }
+
+    Watchdog::~Watchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelled = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+}
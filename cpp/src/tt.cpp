@@ -0,0 +1,136 @@
+#include "headers/tt.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace Hive {
+
+    namespace {
+        // Each search generation of age difference costs as much as this many plies of depth
+        constexpr int AGE_WEIGHT = 4;
+        // Buckets sampled by hashfull
+        constexpr std::size_t HASHFULL_SAMPLE = 1000;
+    }
+
+    TranspositionTable::TranspositionTable(std::size_t sizeMB) {
+        resize(sizeMB);
+    }
+
+    void TranspositionTable::resize(std::size_t sizeMB) {
+        const std::size_t bytes = std::max<std::size_t>(sizeMB, 1) << 20;
+
+        std::size_t count = 1;
+        while (count * 2 * sizeof(Bucket) <= bytes) count *= 2;
+
+        if (count != bucketCount) {
+            buckets.reset(count);
+            bucketCount = count;
+        }
+        clear();
+    }
+
+    void TranspositionTable::clear() {
+        // An unmapped table starts empty
+        for (std::size_t i = 0; buckets.allocated() && i < bucketCount; ++i) {
+            for (Entry& e : buckets[i].entries) {
+                e.keyXorData.store(0, std::memory_order_relaxed);
+                e.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+        stats.probes.store(0, std::memory_order_relaxed);
+        stats.hits.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t TranspositionTable::pack(std::uint32_t move, int score, int depth, Bound bound, std::uint8_t age) {
+        return static_cast<std::uint64_t>(move)
+             | (static_cast<std::uint64_t>(static_cast<std::uint16_t>(static_cast<std::int16_t>(score))) << 32)
+             | (static_cast<std::uint64_t>(std::clamp(depth, 0, 255)) << 48)
+             | (static_cast<std::uint64_t>(bound) << 56)
+             | (static_cast<std::uint64_t>(age & AGE_MASK) << 58);
+    }
+
+    TTData TranspositionTable::unpack(std::uint64_t data) {
+        TTData out;
+        out.move = static_cast<std::uint32_t>(data);
+        out.score = static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 32));
+        out.depth = static_cast<int>((data >> 48) & 0xFF);
+        out.bound = static_cast<Bound>((data >> 56) & 0x3);
+        return out;
+    }
+
+    bool TranspositionTable::probe(std::uint64_t key, TTData& out) {
+        const bool counted = SampleProbe();
+        if (counted) stats.probes.fetch_add(1, std::memory_order_relaxed);
+
+        for (Entry& e : bucketOf(key).entries) {
+            const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+            const std::uint64_t keyXorData = e.keyXorData.load(std::memory_order_relaxed);
+            if (data != 0 && (keyXorData ^ data) == key) {
+                out = unpack(data);
+                if (counted) stats.hits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TranspositionTable::store(std::uint64_t key, std::uint32_t move, int score, int depth, Bound bound) {
+        Bucket& bucket = bucketOf(key);
+
+        Entry* victim = &bucket.entries[0];
+        int victimValue = INT32_MAX;
+        std::uint64_t victimData = 0;
+        bool samePosition = false;
+
+        for (Entry& e : bucket.entries) {
+            const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+            const std::uint64_t keyXorData = e.keyXorData.load(std::memory_order_relaxed);
+
+            // Same position: always refresh it
+            if (data == 0 || (keyXorData ^ data) == key) {
+                victim = &e;
+                victimData = data;
+                samePosition = (data != 0);
+                break;
+            }
+
+            // Otherwise replace the shallowest entry, aged entries counting as shallower
+            const int age = (generation - ageOf(data)) & AGE_MASK;
+            const int value = static_cast<int>((data >> 48) & 0xFF) - AGE_WEIGHT * age;
+            if (value < victimValue) {
+                victim = &e;
+                victimValue = value;
+                victimData = data;
+            }
+        }
+
+        // Keep the best move of a previous visit of the same position if this one has none
+        if (move == 0 && samePosition) {
+            move = static_cast<std::uint32_t>(victimData);
+        }
+
+        const std::uint64_t data = pack(move, score, depth, bound, generation);
+        victim->keyXorData.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    int TranspositionTable::hashfull() const {
+        if (!buckets.allocated()) return 0;
+        const std::size_t sample = std::min(bucketCount, HASHFULL_SAMPLE);
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < sample; ++i) {
+            for (const Entry& e : buckets[i].entries) {
+                const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+                if (data != 0 && ageOf(data) == generation) ++used;
+            }
+        }
+        return static_cast<int>(used * 1000 / (sample * BUCKET_SIZE));
+    }
+
+    int TranspositionTable::hitRate() const {
+        const std::uint64_t p = stats.probes.load(std::memory_order_relaxed);
+        return p == 0 ? 0 : static_cast<int>(stats.hits.load(std::memory_order_relaxed) * 1000 / p);
+    }
+
+}
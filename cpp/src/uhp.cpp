@@ -1,76 +1,169 @@
 #include "headers/uhp.h"
+#include "headers/bench.h"
+#include "headers/commandqueue.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <chrono>
 #include <random>
 
 namespace Hive {
 
+    namespace {
+        // Value of the path options: the rest of the line after "options set <Name>", spaces included. Missing or
+        // "" for an empty path
+        std::string PathValue(const std::string& line) {
+            std::istringstream stream(line);
+            std::string skipped;
+            for (int i = 0; i < 3; ++i) stream >> skipped;
+            std::string value;
+            std::getline(stream, value);
+            const std::size_t first = value.find_first_not_of(" \t");
+            if (first == std::string::npos) return "";
+            value = value.substr(first, value.find_last_not_of(" \t") - first + 1);
+            return (value == "\"\"") ? "" : value;
+        }
+    }
+
     void UhpHandler::loop() {
+        // Reader thread: stdin to the queue. Detached, as it may stay blocked on stdin after "exit": it shares
+        // the ownership of the queue
+        auto queue = std::make_shared<CommandQueue>();
+        std::thread([queue] {
+            std::string line;
+            while (std::getline(std::cin, line)) queue->push(std::move(line));
+            queue->close();
+        }).detach();
+
         std::string line;
-        while (std::getline(std::cin, line)) {
+        bool exitRequested = false;
+        while (queue->pop(line)) {
             if (line.empty()) continue;
 
             std::vector<std::string> chunks = splitCommand(line);
             if (chunks.empty()) continue;
 
             const std::string& cmd = chunks[0];
-
-            if (cmd == "u1") {
-                cmdU1();
-            }
-            else if (cmd == "info") {
-                cmdInfo();
-            }
-            else if (cmd == "newgame") {
-                cmdNewGame(chunks, line);
-            }
-            else if (cmd == "play") {
-                cmdPlay(chunks, line);
-            }
-            else if (cmd == "pass") {
-                cmdPass();
-            }
-            else if (cmd == "validmoves") {
-                cmdValidMoves();
-            }
-            else if (cmd == "bestmove") {
-                cmdBestMove(chunks);
-            }
-            else if (cmd == "undo") {
-                cmdUndo();
-            }
-            else if (cmd == "options") {
-                cmdOptions();
-            }
-            else if (cmd == "exit") {
+            if (cmd == "exit") {
+                exitRequested = true;
                 break;
             }
 
-            // Guarantee buffer flush to MZinga
-            std::cout << std::flush;
+            // The other commands wait for the running bestmove, or stop the ponder search
+            if (cmd == "stop") stopSearch();
+            else if (!isImmediate(chunks)) finishSearch();
+
+            {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                if (cmd == "u1") {
+                    cmdU1();
+                }
+                else if (cmd == "info") {
+                    cmdInfo();
+                }
+                else if (cmd == "newgame") {
+                    cmdNewGame(chunks, line);
+                }
+                else if (cmd == "play") {
+                    cmdPlay(chunks, line);
+                }
+                else if (cmd == "pass") {
+                    cmdPass();
+                }
+                else if (cmd == "validmoves") {
+                    cmdValidMoves();
+                }
+                else if (cmd == "bestmove") {
+                    cmdBestMove(chunks);
+                }
+                else if (cmd == "undo") {
+                    cmdUndo();
+                }
+                else if (cmd == "options") {
+                    cmdOptions(chunks, line);
+                }
+                else if (cmd == "position") {
+                    cmdPosition(chunks);
+                }
+                else if (cmd == "bench") {
+                    cmdBench(chunks);
+                }
+                else if (cmd == "stop") {
+                    std::cout << "ok\n";
+                }
+
+                // Guarantee buffer flush to MZinga
+                std::cout << std::flush;
+            }
+            startPonder();
         }
+
+        // "exit" interrupts a running bestmove, the end of the input lets it finish. Both print its reply
+        if (exitRequested) stopSearch();
+        else finishSearch();
+    }
+
+    UhpHandler::~UhpHandler() {
+        stopSearch();
+    }
+
+    bool UhpHandler::isImmediate(const std::vector<std::string>& chunks) {
+        const std::string& cmd = chunks[0];
+        if (cmd == "u1" || cmd == "info") return true;
+        return cmd == "options" && (chunks.size() < 2 || chunks[1] != "set");
+    }
+
+    // --- Search Thread ---
+
+    void UhpHandler::startSearch(const SearchLimits& limits, std::vector<Piece> hand, std::vector<Move> validMoves, bool isPonder) {
+        engine->setLimits(limits);
+        engine->setGameKeys(gameKeys);
+        engine->resume();
+        pondering = isPonder;
+        searchThread = std::thread([this, engine = engine.get(), board = board, player = turnPlayer,
+                                    hand = std::move(hand), validMoves = std::move(validMoves), isPonder] {
+            const Move bestMove = engine->getBestMove(board, player, hand, validMoves);
+            if (isPonder) return;
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << MoveToString(bestMove, board) << "\n";
+            std::cout << "ok\n" << std::flush;
+        });
+    }
+
+    void UhpHandler::stopSearch() {
+        if (!searchThread.joinable()) return;
+        engine->stop();
+        searchThread.join();
+        engine->resume();
+    }
+
+    void UhpHandler::finishSearch() {
+        if (pondering) stopSearch();
+        else if (searchThread.joinable()) searchThread.join();
+    }
+
+    void UhpHandler::startPonder() {
+        if (!ponder || !engine->canPonder() || searchThread.joinable()) return;
+
+        std::vector<Piece> hand = getHand(turnPlayer);
+        std::vector<Move> validMoves = RuleEngine::generateMoves(board, turnPlayer, hand, lastMoved);
+        if (validMoves.empty()) return;
+
+        SearchLimits limits;
+        limits.moveTime = NO_TIME_LIMIT;
+        startSearch(limits, std::move(hand), std::move(validMoves), true);
     }
 
     // --- State Generators ---
 
     std::vector<Piece> UhpHandler::getHand(Color player) const {
-        std::vector<Piece> startingHand = {
-            {player, Bug::Queen, 1},
-            {player, Bug::Spider, 1}, {player, Bug::Spider, 2},
-            {player, Bug::Beetle, 1}, {player, Bug::Beetle, 2},
-            {player, Bug::Grasshopper, 1}, {player, Bug::Grasshopper, 2}, {player, Bug::Grasshopper, 3},
-            {player, Bug::Ant, 1}, {player, Bug::Ant, 2}, {player, Bug::Ant, 3},
-            {player, Bug::Mosquito, 1},
-            {player, Bug::Ladybug, 1},
-            {player, Bug::Pillbug, 1}
-        };
-
         std::vector<Piece> currentHand;
-        Coord dummy;
-        for (const auto& p : startingHand) {
+        for (int i = 0; i < PIECES_PER_COLOR; ++i) {
+            const Piece p = indexToPiece(static_cast<int>(player) * PIECES_PER_COLOR + i);
             // Only add to hand if it is NOT found on the board
-            if (!findPieceOnBoard(board, p, dummy)) {
+            if (!board.contains(p)) {
                 currentHand.push_back(p);
             }
         }
@@ -91,7 +184,8 @@ namespace Hive {
         // 1. Parse string to move object
         Move move = StringToMove(moveStr, board);
 
-        // 2. Apply to board memory
+        // 2. Apply to board memory. A placement is irreversible: no earlier position can come back
+        recordGameKey(move.type == Move::Place);
         if (move.type == Move::Place) {
             board.place(move.to, move.piece);
         } else if (move.type == Move::PieceMove) {
@@ -100,6 +194,7 @@ namespace Hive {
 
         // 3. Update internal state
         moveHistory.push_back(moveStr);
+        lastMoved = (move.type == Move::Pass) ? std::nullopt : std::optional<Piece>(move.piece);
         gameState = "InProgress";
 
         if (turnPlayer == Color::Black) {
@@ -110,6 +205,37 @@ namespace Hive {
         }
     }
 
+    void UhpHandler::recordGameKey(bool irreversible) {
+        if (irreversible) gameKeys.clear();
+        else gameKeys.push_back(board.key() ^ (turnPlayer == Color::Black ? ZOBRIST_BLACK_TO_MOVE : 0));
+    }
+
+    Position UhpHandler::currentPosition() const {
+        Position position;
+        position.board = board;
+        position.gameType = gameType;
+        position.turnPlayer = turnPlayer;
+        position.turnNumber = turnNumber;
+        position.lastMoved = lastMoved;
+        for (Color c : {Color::White, Color::Black}) {
+            for (const Piece& p : getHand(c)) {
+                position.hands[static_cast<int>(c)] |= static_cast<std::uint16_t>(1u << (pieceIndex(p) % PIECES_PER_COLOR));
+            }
+        }
+        return position;
+    }
+
+    void UhpHandler::loadPosition(const Position& position) {
+        board = position.board;
+        gameType = position.gameType;
+        turnPlayer = position.turnPlayer;
+        turnNumber = position.turnNumber;
+        lastMoved = position.lastMoved;
+        moveHistory.clear();
+        gameKeys.clear();
+        gameState = board.occupiedCoords().empty() ? "NotStarted" : "InProgress";
+    }
+
     // ----- Command Handlers -----
 
     void UhpHandler::cmdU1() {
@@ -127,6 +253,8 @@ namespace Hive {
         // Reset state
         board = Board();
         moveHistory.clear();
+        gameKeys.clear();
+        lastMoved.reset();
         turnNumber = 1;
         turnPlayer = Color::White;
         gameState = "NotStarted";
@@ -170,7 +298,9 @@ namespace Hive {
 
     void UhpHandler::cmdPass() {
         // A pass is technically a move in UHP. We apply it directly.
+        recordGameKey(false);
         moveHistory.push_back("pass");
+        lastMoved.reset();
 
         if (turnPlayer == Color::Black) {
             turnNumber++;
@@ -185,7 +315,7 @@ namespace Hive {
 
     void UhpHandler::cmdValidMoves() const {
         std::vector<Piece> hand = getHand(turnPlayer);
-        std::vector<Move> validMoves = RuleEngine::generateMoves(board, turnPlayer, hand);
+        std::vector<Move> validMoves = RuleEngine::generateMoves(board, turnPlayer, hand, lastMoved);
 
         if (validMoves.empty()) {
             std::cout << "pass\n";
@@ -201,10 +331,55 @@ namespace Hive {
         std::cout << "ok\n";
     }
 
-    void UhpHandler::cmdBestMove(const std::vector<std::string>& chunks) const {
-        // assume bestmove time 00:00:05
+    bool UhpHandler::ParseSearchLimits(const std::vector<std::string>& chunks, SearchLimits& limits) {
+        constexpr long long MAX_HOURS = 24 * 365;
+        limits = SearchLimits();
+        if (chunks.size() == 1) return true;
+        if (chunks.size() != 3) return false;
+
+        const std::string& value = chunks[2];
+        try {
+            if (chunks[1] == "depth") {
+                std::size_t used = 0;
+                const int depth = std::stoi(value, &used);
+                if (used != value.size() || depth < 1) return false;
+                limits.depth = depth;
+                limits.moveTime = NO_TIME_LIMIT;
+                return true;
+            }
+            if (chunks[1] == "time") {
+                // hh:mm:ss, at most MAX_HOURS hours
+                std::istringstream fields(value);
+                std::string field;
+                long long seconds = 0;
+                int count = 0;
+                while (std::getline(fields, field, ':')) {
+                    std::size_t used = 0;
+                    const long long n = field.empty() ? -1 : std::stoll(field, &used);
+                    if (used != field.size() || n < 0 || n > (count == 0 ? MAX_HOURS : 59)) return false;
+                    seconds = seconds * 60 + n;
+                    ++count;
+                }
+                if (count != 3) return false;
+                if (seconds == 0) return false;
+                limits.moveTime = std::min<std::chrono::milliseconds>(std::chrono::seconds(seconds), NO_TIME_LIMIT);
+                return true;
+            }
+        } catch (const std::exception&) {
+        }
+        return false;
+    }
+
+    void UhpHandler::cmdBestMove(const std::vector<std::string>& chunks) {
+        SearchLimits limits;
+        if (!ParseSearchLimits(chunks, limits)) {
+            std::cout << "err Invalid bestmove arguments: expected \"time hh:mm:ss\" or \"depth N\"\n";
+            std::cout << "ok\n";
+            return;
+        }
+
         std::vector<Piece> hand = getHand(turnPlayer);
-        std::vector<Move> validMoves = RuleEngine::generateMoves(board, turnPlayer, hand);
+        std::vector<Move> validMoves = RuleEngine::generateMoves(board, turnPlayer, hand, lastMoved);
 
         if (validMoves.empty()) {
             std::cout << "pass\n";
@@ -212,9 +387,74 @@ namespace Hive {
             return;
         }
 
-        Move bestMove = engine->getBestMove(board, turnPlayer, hand, validMoves);
+        Move bookMove;
+        if (book && book->pick(currentPosition(), validMoves, bookRng, bookMove)) {
+            std::cout << MoveToString(bookMove, board) << "\n";
+            std::cout << "ok\n";
+            return;
+        }
 
-        std::cout << MoveToString(bestMove, board) << "\n";
+        // The reply comes from the search thread
+        startSearch(limits, std::move(hand), std::move(validMoves), false);
+    }
+
+    void UhpHandler::cmdPosition(const std::vector<std::string>& chunks) {
+        const bool binary = chunks.size() > 1 && chunks[1] == "bin";
+        const size_t argIdx = binary ? 2 : 1;
+
+        try {
+            if (chunks.size() > argIdx) {
+                // Load: a single linear parse, no move replay
+                const Position position = binary ? BytesToPosition(HexToBytes(chunks[argIdx]))
+                                                 : StringToPosition(chunks[argIdx]);
+                loadPosition(position);
+                std::cout << generateGameString() << "\n";
+            } else {
+                const Position position = currentPosition();
+                std::cout << (binary ? BytesToHex(PositionToBytes(position)) : PositionToString(position)) << "\n";
+            }
+        } catch (const std::exception& e) {
+            std::cout << "err " << e.what() << "\n";
+        }
+        std::cout << "ok\n";
+    }
+
+    void UhpHandler::cmdBench(const std::vector<std::string>& chunks) {
+        const std::string name = chunks.size() > 1 ? chunks[1] : "smp";
+        try {
+            if (name == "smp") {
+                const int depth = chunks.size() > 2 ? std::stoi(chunks[2]) : 4;
+                const int maxThreads = chunks.size() > 3 ? std::stoi(chunks[3]) : 32;
+                Bench::smp(std::cout, depth, maxThreads);
+            } else if (name == "order") {
+                const int depth = chunks.size() > 2 ? std::stoi(chunks[2]) : 4;
+                Bench::ordering(std::cout, depth);
+            } else if (name == "mcts") {
+                const int moveTimeMs = chunks.size() > 2 ? std::stoi(chunks[2]) : 1000;
+                const int maxThreads = chunks.size() > 3 ? std::stoi(chunks[3]) : 32;
+                const int games = chunks.size() > 4 ? std::stoi(chunks[4]) : 0;
+                Bench::mcts(std::cout, moveTimeMs, maxThreads, games);
+            } else if (name == "graph") {
+                const int playouts = chunks.size() > 2 ? std::stoi(chunks[2]) : 20000;
+                Bench::graph(std::cout, playouts);
+            } else if (name == "widening") {
+                const int playouts = chunks.size() > 2 ? std::stoi(chunks[2]) : 20000;
+                Bench::widening(std::cout, playouts);
+            } else if (name == "rollout") {
+                const int playouts = chunks.size() > 2 ? std::stoi(chunks[2]) : 1000;
+                Bench::rollout(std::cout, playouts);
+            } else if (name == "nnue") {
+                const int evals = chunks.size() > 2 ? std::stoi(chunks[2]) : 100000;
+                Bench::nnue(std::cout, evals);
+            } else if (name == "symmetry") {
+                const int depth = chunks.size() > 2 ? std::stoi(chunks[2]) : 3;
+                Bench::symmetry(std::cout, depth);
+            } else {
+                std::cout << "err Unknown benchmark: " << name << "\n";
+            }
+        } catch (const std::exception& e) {
+            std::cout << "err " << e.what() << "\n";
+        }
         std::cout << "ok\n";
     }
 
@@ -223,9 +463,123 @@ namespace Hive {
         std::cout << "ok\n";
     }
 
-    void UhpHandler::cmdOptions() {
-        // TODO
-        // Reserved for engine options
+    std::string UhpHandler::OptionToString(const EngineOption& option) {
+        std::string str = option.name + ";" + option.type + ";" + option.value + ";" + option.defaultValue;
+        for (const auto& r : option.range) str += ";" + r;
+        return str;
+    }
+
+    std::unique_ptr<Engine> UhpHandler::CreateEngine(const std::string& name) {
+        if (name == "AlphaBeta") return std::make_unique<AlphaBetaEngine>();
+        if (name == "Mcts") return std::make_unique<MctsEngine>();
+        if (name == "Dfpn") return std::make_unique<DfpnEngine>();
+        return nullptr;
+    }
+
+    bool UhpHandler::loadEvalFile(const std::string& path) {
+        try {
+            SetEvalWeights(path.empty() ? EvalWeights{} : LoadEvalWeights(path));
+        } catch (const std::invalid_argument& e) {
+            std::cout << "err " << e.what() << "\n";
+            return false;
+        }
+        evalFile = path;
+        return true;
+    }
+
+    bool UhpHandler::loadNnueFile(const std::string& path) {
+        try {
+            SetNetwork(path.empty() ? nullptr : Network::load(path));
+        } catch (const std::invalid_argument& e) {
+            std::cout << "err " << e.what() << "\n";
+            return false;
+        }
+        nnueFile = path;
+        return true;
+    }
+
+    bool UhpHandler::loadBookFile(const std::string& path) {
+        try {
+            book = path.empty() ? nullptr : std::make_unique<OpeningBook>(path);
+        } catch (const std::invalid_argument& e) {
+            std::cout << "err " << e.what() << "\n";
+            return false;
+        }
+        bookFile = path;
+        return true;
+    }
+
+    std::vector<EngineOption> UhpHandler::allOptions() const {
+        std::vector<EngineOption> options = {{"Engine", "enum", engineName, "AlphaBeta", {"AlphaBeta", "Mcts", "Dfpn"}},
+                                             {"EvalFile", PATH_OPTION, evalFile, "", {}},
+                                             {"NnueFile", PATH_OPTION, nnueFile, "", {}},
+                                             {"BookFile", PATH_OPTION, bookFile, "", {}},
+                                             {"Ponder", "bool", ponder ? "True" : "False", "False", {}},
+                                             {"LargePages", "bool", LargePagesEnabled() ? "True" : "False", "True", {}}};
+        for (auto& option : engine->getOptions()) options.push_back(std::move(option));
+        return options;
+    }
+
+    void UhpHandler::cmdOptions(const std::vector<std::string>& chunks, const std::string& line) {
+        if (chunks.size() == 1) {
+            // The path options are not UHP option types: left out of the listing that GUIs parse
+            for (const auto& option : allOptions()) {
+                if (option.type != PATH_OPTION) std::cout << OptionToString(option) << "\n";
+            }
+            std::cout << "ok\n";
+            return;
+        }
+
+        const std::string& action = chunks[1];
+        const std::string name = chunks.size() > 2 ? chunks[2] : "";
+        const bool isPath = (name == "EvalFile" || name == "NnueFile" || name == "BookFile");
+
+        if (action == "set" && isPath) {
+            const std::string path = PathValue(line);
+            const bool valid = (name == "EvalFile") ? loadEvalFile(path)
+                             : (name == "NnueFile") ? loadNnueFile(path)
+                             : loadBookFile(path);
+            if (!valid) {
+                std::cout << "err Invalid option or value: " << name << "\n";
+                std::cout << "ok\n";
+                return;
+            }
+        } else if (action == "set" && chunks.size() > 3) {
+            bool valid;
+            if (name == "Engine") {
+                std::unique_ptr<Engine> created = CreateEngine(chunks[3]);
+                valid = (created != nullptr);
+                if (valid) {
+                    engine = std::move(created);
+                    engineName = chunks[3];
+                }
+            } else if (name == "LargePages") {
+                valid = (chunks[3] == "True" || chunks[3] == "False");
+                if (valid) SetLargePages(chunks[3] == "True");
+            } else if (name == "Ponder") {
+                valid = (chunks[3] == "True" || chunks[3] == "False");
+                if (valid) ponder = (chunks[3] == "True");
+            } else {
+                valid = engine->setOption(name, chunks[3]);
+            }
+            if (!valid) {
+                std::cout << "err Invalid option or value: " << name << "\n";
+                std::cout << "ok\n";
+                return;
+            }
+        }
+
+        if (action == "get" || action == "set") {
+            for (const auto& option : allOptions()) {
+                if (option.name == name) {
+                    std::cout << OptionToString(option) << "\n";
+                    std::cout << "ok\n";
+                    return;
+                }
+            }
+        }
+        std::cout << "err Invalid option: " << name << "\n";
+        std::cout << "ok\n";
     }
 
 } // namespace Hive
\ No newline at end of file
@@ -103,20 +103,9 @@ namespace Hive
     }
 
 
-    // Helper to find a piece's coordinate on the board by scanning occupied cells
-    static bool findPieceOnBoard(const Board& board, const Piece& targetPiece, Coord& outCoord) {
-        for (Coord c : board.occupiedCoords()) {
-            int idx = Board::AxToIndex(c);
-            // We only need to check the top of the stack for movement origins,
-            // but for references, UHP allows referencing covered pieces.
-            // Assuming the board's CellStack has a way to iterate or we just check the top for now.
-            const Piece* topPiece = board.top(c);
-            if (topPiece && topPiece->color == targetPiece.color && topPiece->bug == targetPiece.bug && topPiece->id == targetPiece.id) {
-                outCoord = c;
-                return true;
-            }
-        }
-        return false;
+    // Helper to find a piece's coordinate on the board, covered pieces included
+    bool findPieceOnBoard(const Board& board, const Piece& targetPiece, Coord& outCoord) {
+        return board.locate(targetPiece, outCoord);
     }
 
     Move StringToMove(const std::string& moveStr, const Board& board) {